@@ -0,0 +1,311 @@
+#ifndef BACKEND_HEALTH_H
+#define BACKEND_HEALTH_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "hash_ring.h"
+
+// How the proxy picks a backend for a new session
+enum class RoutingPolicy {
+    Affinity,   // the backend owning the robot_id, or the next available one after it on the ring
+    Latency     // the available backend with the lowest cost, whatever the robot
+};
+
+struct HealthOptions {
+    // A probe goes out every interval and fails if unanswered within the timeout
+    uint32_t probeIntervalMs = 500;
+    uint32_t probeTimeoutMs = 1000;
+    // Failed probes in a row that take a backend down, and answered ones that bring it back
+    uint32_t unhealthyThreshold = 3;
+    uint32_t healthyThreshold = 2;
+    // A backend whose probe RTT exceeds outlierFactor times the median of
+    // the backends, and the median by outlierMinUs, is ejected as an outlier
+    double outlierFactor = 3.0;
+    uint32_t outlierMinUs = 20000;
+    // Ejection time, doubled for every ejection that follows within
+    // maxEjectionMs of the last one ending, up to maxEjectionMs
+    uint32_t ejectionMs = 10000;
+    uint32_t maxEjectionMs = 300000;
+    // Outlier ejection never takes out more than this share of the backends
+    uint32_t maxEjectedPercent = 50;
+    // A backend this loaded takes no new sessions while another one can
+    uint32_t overloadedQueueDepth = 64;
+    double overloadedUtilization = 0.9;
+    // Cost of load in microseconds of RTT: per queued command, and for a full session table
+    uint32_t queuePenaltyUs = 2000;
+    uint32_t utilizationPenaltyUs = 50000;
+};
+
+// One backend as last probed, for metrics and tests
+struct BackendStatus {
+    std::string name;
+    bool up{true};
+    bool ejected{false};
+    bool overloaded{false};
+    bool available{true};       // up, not ejected and not overloaded
+    double probeRttUs{0};
+    uint32_t transportRttUs{0};
+    double errorRate{0};
+    uint32_t queueDepth{0};
+    uint32_t sessions{0};
+    uint32_t sessionCapacity{0};
+    double cost{0};
+    uint64_t probes{0};
+    uint64_t failedProbes{0};
+    uint64_t ejections{0};
+};
+
+// Health of the proxy's backends from active probes. Every probe answer
+// carries the round trip and the server's load; unanswered probes count as
+// errors. A backend is taken down after unhealthyThreshold failures in a row,
+// ejected for a while when its latency is an outlier among its peers, and
+// passed over while overloaded. New sessions go to available backends only,
+// ranked by cost: latency plus a penalty for load, so a far but idle server
+// wins over a close one with a backlog. Backends that were never probed are
+// assumed up but rank last.
+class BackendHealth {
+    struct State {
+        bool up{true};
+        bool probed{false};
+        uint32_t successes{0};          // in a row
+        uint32_t failures{0};           // in a row
+        double probeRttUs{0};           // EWMA of answered probes
+        uint32_t transportRttUs{0};     // msquic's smoothed RTT of the probe connection
+        double errorRate{0};            // EWMA of failed probes
+        uint32_t queueDepth{0};
+        uint32_t sessions{0};
+        uint32_t sessionCapacity{0};
+        uint64_t ejectedUntilUs{0};
+        uint64_t lastEjectionEndUs{0};
+        uint32_t ejectionStreak{0};
+        uint64_t probes{0};
+        uint64_t failedProbes{0};
+        uint64_t ejections{0};
+    };
+
+    static constexpr double RttWeight = 0.3;
+    static constexpr double ErrorWeight = 0.1;
+
+    HealthOptions settings;
+    std::unordered_map<std::string, State> states;
+    mutable std::mutex lock;    // probes, routing and scrapes run on different threads
+
+    bool ejected(const State& state, uint64_t nowUs) const { return nowUs < state.ejectedUntilUs; }
+
+    bool overloaded(const State& state) const {
+        return state.queueDepth >= settings.overloadedQueueDepth ||
+               (state.sessionCapacity && state.sessions >= settings.overloadedUtilization * state.sessionCapacity);
+    }
+
+    bool available(const State& state, uint64_t nowUs) const {
+        return state.up && !ejected(state, nowUs) && !overloaded(state);
+    }
+
+    double cost(const State& state) const {
+        if (!state.probed) {
+            return std::numeric_limits<double>::max();
+        }
+        double rtt = state.probeRttUs ? state.probeRttUs : state.transportRttUs;
+        double load = static_cast<double>(settings.queuePenaltyUs) * state.queueDepth;
+        if (state.sessionCapacity) {
+            load += static_cast<double>(settings.utilizationPenaltyUs) * state.sessions / state.sessionCapacity;
+        }
+        return (rtt + load) / (1.0 - std::min(state.errorRate, 0.9));
+    }
+
+    // A backend outside the table (added since the last probe round) is usable
+    const State* find(const std::string& name) const {
+        auto it = states.find(name);
+        return it == states.end() ? nullptr : &it->second;
+    }
+
+    bool canEject(uint64_t nowUs) const {
+        size_t ejectedCount = 0;
+        for (const auto& entry : states) {
+            ejectedCount += ejected(entry.second, nowUs);
+        }
+        return (ejectedCount + 1) * 100 <= states.size() * settings.maxEjectedPercent;
+    }
+
+    void eject(State& state, uint64_t nowUs) {
+        if (state.lastEjectionEndUs && nowUs - state.lastEjectionEndUs >= settings.maxEjectionMs * 1000ull) {
+            state.ejectionStreak = 0;
+        }
+        uint64_t durationMs = static_cast<uint64_t>(settings.ejectionMs) << std::min<uint32_t>(state.ejectionStreak, 16);
+        durationMs = std::min<uint64_t>(durationMs, settings.maxEjectionMs);
+        state.ejectedUntilUs = nowUs + durationMs * 1000;
+        ++state.ejectionStreak;
+        ++state.ejections;
+    }
+
+public:
+    static uint64_t clockUs() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // Set before the proxy starts probing
+    void setOptions(const HealthOptions& options) {
+        std::lock_guard<std::mutex> guard(lock);
+        settings = options;
+    }
+    const HealthOptions& options() const { return settings; }
+
+    // Starts tracking a backend; results for untracked backends are ignored
+    void track(const std::string& name) {
+        std::lock_guard<std::mutex> guard(lock);
+        states.emplace(name, State());
+    }
+
+    void forget(const std::string& name) {
+        std::lock_guard<std::mutex> guard(lock);
+        states.erase(name);
+    }
+
+    // An answered probe and the load the server reported with it
+    void recordProbe(const std::string& name, uint64_t rttUs, uint32_t sessions, uint32_t sessionCapacity,
+                     uint32_t queueDepth) {
+        std::lock_guard<std::mutex> guard(lock);
+        auto it = states.find(name);
+        if (it == states.end()) {
+            return;
+        }
+        State& state = it->second;
+        state.probeRttUs = state.probed ? state.probeRttUs + RttWeight * (rttUs - state.probeRttUs)
+                                        : static_cast<double>(rttUs);
+        state.probed = true;
+        state.errorRate -= ErrorWeight * state.errorRate;
+        state.sessions = sessions;
+        state.sessionCapacity = sessionCapacity;
+        state.queueDepth = queueDepth;
+        state.failures = 0;
+        if (++state.successes >= settings.healthyThreshold) {
+            state.up = true;
+        }
+        ++state.probes;
+    }
+
+    // A probe that timed out, or a probe connection that failed or was lost
+    void recordFailure(const std::string& name) {
+        std::lock_guard<std::mutex> guard(lock);
+        auto it = states.find(name);
+        if (it == states.end()) {
+            return;
+        }
+        State& state = it->second;
+        state.errorRate += ErrorWeight * (1.0 - state.errorRate);
+        state.successes = 0;
+        if (++state.failures >= settings.unhealthyThreshold) {
+            state.up = false;
+        }
+        ++state.probes;
+        ++state.failedProbes;
+    }
+
+    void recordTransportRtt(const std::string& name, uint32_t rttUs) {
+        std::lock_guard<std::mutex> guard(lock);
+        auto it = states.find(name);
+        if (it != states.end()) {
+            it->second.transportRttUs = rttUs;
+        }
+    }
+
+    // Ends ejections that ran out and ejects latency outliers; once per probe round
+    void evaluate(uint64_t nowUs) {
+        std::lock_guard<std::mutex> guard(lock);
+        std::vector<std::pair<double, State*>> latencies;
+        for (auto& entry : states) {
+            State& state = entry.second;
+            if (state.ejectedUntilUs && !ejected(state, nowUs)) {
+                // Back in, but judged on its next probes rather than the ones that ejected it
+                state.ejectedUntilUs = 0;
+                state.lastEjectionEndUs = nowUs;
+                state.probed = false;
+            }
+            if (state.probed && state.up && !ejected(state, nowUs)) {
+                latencies.emplace_back(state.probeRttUs, &state);
+            }
+        }
+        // A median of fewer backends says little about what is normal
+        if (latencies.size() < 3) {
+            return;
+        }
+        std::sort(latencies.begin(), latencies.end(),
+                  [](const std::pair<double, State*>& a, const std::pair<double, State*>& b) { return a.first < b.first; });
+        double median = latencies[latencies.size() / 2].first;
+        for (auto it = latencies.rbegin(); it != latencies.rend(); ++it) {
+            if (it->first <= median * settings.outlierFactor || it->first <= median + settings.outlierMinUs ||
+                !canEject(nowUs)) {
+                break;
+            }
+            eject(*it->second, nowUs);
+        }
+    }
+
+    // Picks the backend for a new session on Key (its robot_id). When no
+    // backend is available, one that is up but ejected or overloaded is
+    // better than none, and the key's owner is the last resort.
+    const Backend* select(const HashRing& ring, std::string_view key, RoutingPolicy policy, uint64_t nowUs) const {
+        std::lock_guard<std::mutex> guard(lock);
+        const Backend* chosen = nullptr;
+        if (policy == RoutingPolicy::Latency) {
+            double best = 0;
+            for (const Backend& backend : ring.members()) {
+                const State* state = find(backend.name);
+                double c = state ? cost(*state) : std::numeric_limits<double>::max();
+                if ((!state || available(*state, nowUs)) && (!chosen || c < best)) {
+                    chosen = &backend;
+                    best = c;
+                }
+            }
+        } else {
+            chosen = ring.route(key, [this, nowUs](const Backend& backend) {
+                const State* state = find(backend.name);
+                return !state || available(*state, nowUs);
+            });
+        }
+        if (!chosen) {
+            chosen = ring.route(key, [this](const Backend& backend) {
+                const State* state = find(backend.name);
+                return !state || state->up;
+            });
+        }
+        return chosen ? chosen : ring.route(key);
+    }
+
+    std::vector<BackendStatus> statuses(uint64_t nowUs) const {
+        std::lock_guard<std::mutex> guard(lock);
+        std::vector<BackendStatus> result;
+        result.reserve(states.size());
+        for (const auto& entry : states) {
+            const State& state = entry.second;
+            BackendStatus status;
+            status.name = entry.first;
+            status.up = state.up;
+            status.ejected = ejected(state, nowUs);
+            status.overloaded = overloaded(state);
+            status.available = available(state, nowUs);
+            status.probeRttUs = state.probeRttUs;
+            status.transportRttUs = state.transportRttUs;
+            status.errorRate = state.errorRate;
+            status.queueDepth = state.queueDepth;
+            status.sessions = state.sessions;
+            status.sessionCapacity = state.sessionCapacity;
+            status.cost = state.probed ? cost(state) : 0;
+            status.probes = state.probes;
+            status.failedProbes = state.failedProbes;
+            status.ejections = state.ejections;
+            result.push_back(status);
+        }
+        return result;
+    }
+};
+
+#endif // BACKEND_HEALTH_H
@@ -0,0 +1,109 @@
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include "msquic.h"
+#include "server.h"
+
+// Connection storm: many clients connect at once, as a fleet does after a
+// network blip. Reports how fast the server accepts them.
+// Usage: bench_accept [connections]
+
+struct StormClients {
+    std::atomic<uint64_t> Connected{0};
+    std::atomic<uint64_t> Failed{0};
+};
+
+static QUIC_STATUS QUIC_API StormCallback(HQUIC, void* Context, QUIC_CONNECTION_EVENT* Event) {
+    auto clients = static_cast<StormClients*>(Context);
+    switch (Event->Type) {
+        case QUIC_CONNECTION_EVENT_CONNECTED:
+            clients->Connected.fetch_add(1, std::memory_order_relaxed);
+            break;
+        case QUIC_CONNECTION_EVENT_SHUTDOWN_INITIATED_BY_TRANSPORT:
+            clients->Failed.fetch_add(1, std::memory_order_relaxed);
+            break;
+        default:
+            break;
+    }
+    return QUIC_STATUS_SUCCESS;
+}
+
+int main(int argc, char* argv[]) {
+    const size_t connections = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 500;
+
+    QuicServer server;
+    server.SetVerbose(false);
+    if (!server.Initialize() || !server.Start()) {
+        return 1;
+    }
+
+    const QUIC_API_TABLE* MsQuic = nullptr;
+    HQUIC Registration = nullptr;
+    HQUIC Configuration = nullptr;
+    if (QUIC_FAILED(MsQuicOpen2(&MsQuic))) {
+        std::cerr << "Failed to open MsQuic" << std::endl;
+        return 1;
+    }
+    QUIC_REGISTRATION_CONFIG RegConfig = { "TeleopAcceptBench", QUIC_EXECUTION_PROFILE_LOW_LATENCY };
+    if (QUIC_FAILED(MsQuic->RegistrationOpen(&RegConfig, &Registration))) {
+        std::cerr << "Failed to open registration" << std::endl;
+        return 1;
+    }
+
+    const char* alpnStr = "teleop";
+    QUIC_BUFFER alpn;
+    alpn.Buffer = (uint8_t*)alpnStr;
+    alpn.Length = (uint32_t)strlen(alpnStr);
+    QUIC_SETTINGS Settings = {0};
+    Settings.IsSet.DisconnectTimeoutMs = 1;
+    Settings.DisconnectTimeoutMs = 30000;
+    QUIC_CREDENTIAL_CONFIG CredConfig;
+    memset(&CredConfig, 0, sizeof(CredConfig));
+    CredConfig.Type = QUIC_CREDENTIAL_TYPE_NONE;
+    CredConfig.Flags = QUIC_CREDENTIAL_FLAG_CLIENT | QUIC_CREDENTIAL_FLAG_NO_CERTIFICATE_VALIDATION;
+    if (QUIC_FAILED(MsQuic->ConfigurationOpen(Registration, &alpn, 1, &Settings, sizeof(Settings), nullptr, &Configuration)) ||
+        QUIC_FAILED(MsQuic->ConfigurationLoadCredential(Configuration, &CredConfig))) {
+        std::cerr << "Failed to create client configuration" << std::endl;
+        return 1;
+    }
+
+    StormClients clients;
+    std::vector<HQUIC> handles(connections, nullptr);
+    for (auto& handle : handles) {
+        if (QUIC_FAILED(MsQuic->ConnectionOpen(Registration, StormCallback, &clients, &handle))) {
+            std::cerr << "Failed to open connection" << std::endl;
+            return 1;
+        }
+    }
+
+    uint64_t base = server.GetConnectionsAccepted();
+    auto start = std::chrono::steady_clock::now();
+    for (HQUIC handle : handles) {
+        MsQuic->ConnectionStart(handle, Configuration, QUIC_ADDRESS_FAMILY_INET, "127.0.0.1", 4433);
+    }
+
+    auto deadline = start + std::chrono::seconds(60);
+    while (server.GetConnectionsAccepted() - base < connections &&
+           clients.Connected + clients.Failed < connections &&
+           std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    uint64_t accepted = server.GetConnectionsAccepted() - base;
+
+    std::cout << "Accepted " << accepted << "/" << connections << " connections in "
+              << elapsed * 1000.0 << " ms (" << static_cast<uint64_t>(accepted / elapsed) << " accepts/s, "
+              << clients.Failed << " failed)" << std::endl;
+
+    for (HQUIC handle : handles) {
+        MsQuic->ConnectionClose(handle);
+    }
+    MsQuic->ConfigurationClose(Configuration);
+    MsQuic->RegistrationClose(Registration);
+    MsQuicClose(MsQuic);
+    return accepted == connections ? 0 : 1;
+}
@@ -0,0 +1,133 @@
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "signed_token.h"
+
+// Cost of authorizing a command, from 1 to `threads` threads at once:
+// checking a signed token in full (decode, HMAC-SHA256, constant-time
+// compare and the client_id match), as for the first command of a
+// connection; checking one that repeats the connection's last token; and
+// one mutex around an unordered_map of `tokens` sessions keyed by client id
+// that builds std::strings for the lookup (the proxy's earlier scheme).
+// Commands name the clients in random order. Verifications/sec per core is
+// the single-thread rate of full checks; more threads than cores only shows
+// contention.
+// Usage: bench_auth [tokens] [threads] [lookups_per_thread]
+
+struct MapState {
+    std::string token;
+    uint64_t expiresSec;
+};
+
+template <typename Body>
+static double RunThreads(int threads, size_t lookups, Body body) {
+    std::vector<std::thread> workers;
+    std::atomic<int> ready{0};
+    std::atomic<bool> go{false};
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t]() {
+            ++ready;
+            while (!go) {
+            }
+            body(t);
+        });
+    }
+    while (ready < threads) {
+    }
+    auto start = std::chrono::steady_clock::now();
+    go = true;
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    return ns / lookups;   // wall time per call on each thread
+}
+
+int main(int argc, char* argv[]) {
+    const size_t tokens = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000;
+    const int maxThreads = argc > 2 ? std::atoi(argv[2]) : 4;
+    const size_t lookups = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 1000000;
+    if (tokens == 0 || maxThreads <= 0 || lookups == 0) {
+        std::cerr << "Usage: bench_auth [tokens] [threads] [lookups_per_thread]" << std::endl;
+        return 1;
+    }
+
+    std::mt19937_64 random(1);
+    uint8_t key[32];
+    for (uint8_t& byte : key) {
+        byte = static_cast<uint8_t>(random());
+    }
+    TokenKeyring keys;
+    keys.add(1, key, sizeof(key), true);
+    const uint64_t now = std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    const uint64_t expires = now + 24 * 3600;
+
+    std::unordered_map<std::string, MapState> map;
+    std::mutex mapLock;
+    std::vector<std::string> texts;
+    std::vector<std::string> clients;
+    for (size_t i = 0; i < tokens; ++i) {
+        clients.push_back("operator-" + std::to_string(i));
+        texts.push_back(keys.sign(clients.back(), "robot-" + std::to_string(i % 1000), expires));
+        map[clients.back()] = MapState{texts.back(), expires};
+    }
+    std::vector<size_t> order(tokens);
+    for (size_t& k : order) {
+        k = random() % tokens;
+    }
+    std::cout << "token " << texts[0].size() << " bytes on the wire" << std::endl;
+
+    std::cout << std::setw(8) << "threads" << std::setw(16) << "signed ns/auth" << std::setw(18)
+              << "verifications/s" << std::setw(16) << "repeat ns/auth" << std::setw(14) << "map ns/auth" << std::endl;
+    for (int threads = 1; threads <= maxThreads; threads *= 2) {
+        std::atomic<uint64_t> accepted{0};
+        double signedNs = RunThreads(threads, lookups, [&](int t) {
+            uint64_t ok = 0;
+            SignedToken token;
+            for (size_t i = 0; i < lookups; ++i) {
+                size_t k = order[(i + t * tokens / maxThreads) % tokens];
+                ok += keys.verify(texts[k].data(), texts[k].size(), now, token) == TokenKeyring::Result::Valid &&
+                      token.clientId() == clients[k];
+            }
+            accepted += ok;
+        });
+        double repeatNs = RunThreads(threads, lookups, [&](int t) {
+            uint64_t ok = 0;
+            VerifiedToken last;
+            size_t k = order[t * tokens / maxThreads];
+            for (size_t i = 0; i < lookups; ++i) {
+                ok += keys.verify(texts[k].data(), texts[k].size(), now, last) == TokenKeyring::Result::Valid &&
+                      last.token.clientId() == clients[k];
+            }
+            accepted += ok;
+        });
+        double mapNs = RunThreads(threads, lookups, [&](int t) {
+            uint64_t ok = 0;
+            for (size_t i = 0; i < lookups; ++i) {
+                size_t k = order[(i + t * tokens / maxThreads) % tokens];
+                std::lock_guard<std::mutex> guard(mapLock);
+                auto it = map.find(std::string(clients[k].data(), clients[k].size()));
+                ok += it != map.end() && it->second.token == std::string(texts[k].data(), texts[k].size()) &&
+                      now < it->second.expiresSec;
+            }
+            accepted += ok;
+        });
+        if (accepted != 3 * lookups * threads) {
+            std::cerr << "Valid tokens were refused" << std::endl;
+            return 1;
+        }
+        std::cout << std::setw(8) << threads << std::fixed << std::setprecision(1)
+                  << std::setw(16) << signedNs << std::setw(18) << std::setprecision(0) << threads * 1e9 / signedNs
+                  << std::setw(16) << std::setprecision(1) << repeatNs << std::setw(14) << mapNs << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,85 @@
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+#include "command_queue.h"
+#include "histogram.h"
+
+// Latency of handing commands from receive threads to the control thread
+// through CommandQueue. Each producer stands in for one connection's msquic
+// worker and publishes at a fixed rate; every 50th command is a STOP.
+// Usage: bench_handoff [producers] [rate_hz] [seconds]
+
+static uint64_t NowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void Print(const char* name, const LatencySnapshot& s) {
+    std::cout << name << ": " << s.count << " delivered, p50 " << s.p50 << " ns, p99 " << s.p99
+              << " ns, p99.9 " << s.p999 << " ns, max " << s.max << " ns" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    const int producers = argc > 1 ? std::atoi(argv[1]) : 4;
+    const uint64_t rate = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1000;
+    const int seconds = argc > 3 ? std::atoi(argv[3]) : 5;
+    if (producers <= 0 || rate == 0 || seconds <= 0) {
+        std::cerr << "Usage: bench_handoff [producers] [rate_hz] [seconds]" << std::endl;
+        return 1;
+    }
+
+    CommandQueue queue;
+    std::atomic<bool> running{true};
+    std::atomic<uint64_t> published{0};
+
+    // Control thread: sentUs carries the publish time in nanoseconds here
+    LatencyHistogram setpoints;
+    LatencyHistogram stops;
+    std::thread consumer([&]() {
+        auto handle = [&](const ControlSetpoint& setpoint) {
+            uint64_t latency = NowNs() - setpoint.sentUs;
+            (setpoint.isUrgent() ? stops : setpoints).record(latency);
+        };
+        while (running.load(std::memory_order_relaxed)) {
+            queue.drain(handle);
+            queue.wait(std::chrono::milliseconds(10));
+        }
+        queue.drain(handle);
+    });
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&]() {
+            int32_t mailbox = queue.openMailbox();
+            const auto period = std::chrono::nanoseconds(1000000000ull / rate);
+            auto deadline = std::chrono::steady_clock::now();
+            auto end = deadline + std::chrono::seconds(seconds);
+            uint32_t sequence = 0;
+            while (deadline < end) {
+                ControlSetpoint setpoint{};
+                setpoint.sequence = ++sequence;
+                setpoint.type = sequence % 50 == 0 ? Teleop::CommandType_STOP : Teleop::CommandType_MOVE;
+                setpoint.linearVelocity = 0.5f;
+                setpoint.sentUs = NowNs();
+                queue.publish(mailbox, setpoint);
+                published.fetch_add(1, std::memory_order_relaxed);
+                deadline += period;
+                std::this_thread::sleep_until(deadline);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    running = false;
+    consumer.join();
+
+    std::cout << producers << " producers at " << rate << " Hz for " << seconds << " s: "
+              << published.load() << " published, " << queue.overwrittenCount() << " overwritten" << std::endl;
+    Print("Setpoints", setpoints.snapshot());
+    Print("Stops", stops.snapshot());
+    return 0;
+}
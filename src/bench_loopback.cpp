@@ -0,0 +1,149 @@
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <sys/resource.h>
+#include "server.h"
+#include "client.h"
+
+// End-to-end latency over 127.0.0.1 with no external network: a server and
+// N clients in one process. Every client sends MOVE commands at the given
+// rate (0 = as fast as its send buffers allow) with the given padding, and
+// the server echoes each one, so the report has one-way latency (client send
+// to server receive), round trip (client send to echo receive), throughput,
+// and CPU time of the whole process per command. The journal is off.
+// Usage: bench_loopback [clients] [rate_hz] [payload_bytes] [seconds] [--datagram]
+
+static bool WaitFor(const std::function<bool()>& done, std::chrono::seconds timeout) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (!done()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+static double CpuSeconds() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+static void Print(const char* name, const LatencySnapshot& s) {
+    std::cout << name << " (us): p50 " << s.p50 << " p90 " << s.p90 << " p99 " << s.p99
+              << " p99.9 " << s.p999 << " max " << s.max << " over " << s.count << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<const char*> args;
+    CommandTransport transport = CommandTransport::Stream;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--datagram") == 0) {
+            transport = CommandTransport::Datagram;
+        } else {
+            args.push_back(argv[i]);
+        }
+    }
+    const uint32_t clients = args.size() > 0 ? std::strtoul(args[0], nullptr, 10) : 4;
+    const double rate = args.size() > 1 ? std::atof(args[1]) : 1000.0;
+    const size_t payload = args.size() > 2 ? std::strtoul(args[2], nullptr, 10) : 0;
+    const uint32_t seconds = args.size() > 3 ? std::strtoul(args[3], nullptr, 10) : 5;
+    if (clients == 0 || rate < 0 || rate > 100000 || seconds == 0) {
+        std::cerr << "Usage: bench_loopback [clients] [rate_hz] [payload_bytes] [seconds] [--datagram]" << std::endl;
+        return 1;
+    }
+
+    ServerOptions options;
+    options.listen = {{"127.0.0.1", 4733}};
+    options.journalDirectory.clear();
+    options.echoCommands = true;
+    QuicServer server(options);
+    server.SetVerbose(false);
+    if (!server.Initialize() || !server.Start()) {
+        return 1;
+    }
+
+    std::vector<std::unique_ptr<QuicClient>> fleet;
+    for (uint32_t c = 0; c < clients; ++c) {
+        fleet.emplace_back(new QuicClient(transport));
+        QuicClient& client = *fleet.back();
+        client.SetCommandPadding(payload);
+        if (!client.Initialize() || !client.Connect("127.0.0.1", 4733)) {
+            return 1;
+        }
+    }
+    if (!WaitFor([&fleet]() {
+            for (auto& client : fleet) {
+                if (!client->IsConnected()) return false;
+            }
+            return true;
+        }, std::chrono::seconds(10))) {
+        std::cerr << "Clients did not connect" << std::endl;
+        return 1;
+    }
+    // Let the datagram negotiation settle, so the first echoes are not missed
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    std::atomic<uint64_t> sent{0};
+    std::atomic<uint64_t> skipped{0};
+    const double cpuStart = CpuSeconds();
+    const auto start = std::chrono::steady_clock::now();
+    const auto end = start + std::chrono::seconds(seconds);
+    std::vector<std::thread> senders;
+    for (auto& client : fleet) {
+        QuicClient* c = client.get();
+        senders.emplace_back([c, rate, end, &sent, &skipped]() {
+            RateLoopOptions loopOptions;
+            loopOptions.rateHz = rate > 0 ? rate : 1.0;
+            RateLoop loop(loopOptions);
+            loop.start();
+            while (std::chrono::steady_clock::now() < end) {
+                if (c->SendControlCommand(0.5f, 0.0f)) {
+                    sent.fetch_add(1, std::memory_order_relaxed);
+                } else if (rate > 0) {
+                    skipped.fetch_add(1, std::memory_order_relaxed);
+                } else {
+                    // All send buffers are in flight; let msquic drain them
+                    std::this_thread::yield();
+                }
+                if (rate > 0) {
+                    loop.wait();
+                }
+            }
+        });
+    }
+    for (auto& thread : senders) {
+        thread.join();
+    }
+    bool complete = WaitFor([&]() { return server.GetCommandsReceived() >= sent.load(); }, std::chrono::seconds(10));
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double cpu = CpuSeconds() - cpuStart;
+    // Echoes still in flight
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    uint64_t received = server.GetCommandsReceived();
+    LatencyHistogram roundTrip;
+    for (auto& client : fleet) {
+        roundTrip.merge(client->GetRoundTrip());
+    }
+    std::cout << clients << " clients at " << (rate > 0 ? std::to_string(static_cast<uint64_t>(rate)) + " Hz" : "full rate")
+              << ", " << payload << " byte padding, " << (transport == CommandTransport::Datagram ? "datagrams" : "stream")
+              << ", " << seconds << " s" << std::endl;
+    std::cout << "Commands: " << sent.load() << " sent, " << received << " received, "
+              << skipped.load() << " skipped (no free send buffer)" << std::endl;
+    std::cout << "Throughput: " << static_cast<uint64_t>(received / elapsed) << " msg/s" << std::endl;
+    Print("One-way", server.GetLatency().snapshot());
+    Print("Round trip", roundTrip.snapshot());
+    std::cout << "CPU: " << (received ? cpu * 1e6 / received : 0.0) << " us per message, "
+              << 100.0 * cpu / elapsed << "% of one core (server and clients)" << std::endl;
+
+    fleet.clear();
+    return complete ? 0 : 1;
+}
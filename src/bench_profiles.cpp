@@ -0,0 +1,99 @@
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <thread>
+#include "server.h"
+#include "client.h"
+
+// What each transport profile costs: for every profile a server and a client
+// using it are started in one process over 127.0.0.1. The client first sends
+// 1000 commands at 1 kHz and the server reports their one-way latency, then
+// sends a burst as fast as it can for throughput. Loopback has no loss and
+// almost no delay, so this shows the cost of pacing, ACK delay and buffering;
+// compare congestion controllers on a real or emulated (netem) link.
+// Usage: bench_profiles [messages] [profile_file]
+
+static bool WaitFor(const std::function<bool()>& done, std::chrono::seconds timeout) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (!done()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+static bool RunProfile(const TransportProfile& profile, uint16_t port, uint64_t messages) {
+    ServerOptions options;
+    options.listen = {{"127.0.0.1", port}};
+    options.transport = profile;
+    options.journalDirectory.clear();
+    QuicServer server(options);
+    server.SetVerbose(false);
+    if (!server.Initialize() || !server.Start()) {
+        return false;
+    }
+    QuicClient client;
+    client.SetTransportProfile(profile);
+    if (!client.Initialize() || !client.Connect("127.0.0.1", port) ||
+        !WaitFor([&client]() { return client.IsConnected(); }, std::chrono::seconds(5))) {
+        std::cerr << profile.name << ": connection failed" << std::endl;
+        return false;
+    }
+
+    // Paced: latency without self-inflicted queueing
+    const uint64_t paced = 1000;
+    auto next = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < paced; ++i) {
+        next += std::chrono::milliseconds(1);
+        client.SendControlCommand(0.5f, 0.0f);
+        std::this_thread::sleep_until(next);
+    }
+    WaitFor([&]() { return server.GetCommandsReceived() >= paced; }, std::chrono::seconds(5));
+    LatencySnapshot latency = server.GetLatency().snapshot();
+
+    // Burst: throughput
+    uint64_t base = server.GetCommandsReceived();
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t sent = 0; sent < messages; ) {
+        if (client.SendControlCommand(0.5f, 0.0f)) {
+            ++sent;
+        } else {
+            // All send buffers are in flight; let msquic drain them
+            std::this_thread::yield();
+        }
+    }
+    bool complete = WaitFor([&]() { return server.GetCommandsReceived() - base >= messages; },
+                            std::chrono::seconds(60));
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    uint64_t received = server.GetCommandsReceived() - base;
+
+    std::cout << std::left << std::setw(22) << profile.name << std::right
+              << std::setw(9) << latency.p50 << std::setw(9) << latency.p99 << std::setw(9) << latency.max
+              << std::setw(12) << static_cast<uint64_t>(received / elapsed)
+              << (complete ? "" : " (timed out)") << std::endl;
+    return complete;
+}
+
+int main(int argc, char* argv[]) {
+    uint64_t messages = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100000;
+    TransportProfiles profiles;
+    std::string error;
+    if (argc > 2 && !profiles.loadFile(argv[2], error)) {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+
+    std::cout << std::left << std::setw(22) << "profile" << std::right
+              << std::setw(9) << "p50 us" << std::setw(9) << "p99 us" << std::setw(9) << "max us"
+              << std::setw(12) << "msg/s" << std::endl;
+    uint16_t port = 4633;
+    bool ok = true;
+    for (const std::string& name : profiles.names()) {
+        ok = RunProfile(*profiles.find(name), port++, messages) && ok;
+    }
+    return ok ? 0 : 1;
+}
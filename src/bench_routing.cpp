@@ -0,0 +1,87 @@
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include "hash_ring.h"
+
+// Cost of routing by robot_id on the proxy's consistent hash ring, for 2 to
+// max_backends backends: a lookup on a ring held by the caller, and one that
+// first takes a snapshot of the BackendPool as a new session does. Also shows
+// the share of keys the busiest backend owns and how many keys move when one
+// more backend is added (ideally 1/(n+1)).
+// Usage: bench_routing [max_backends] [keys] [lookups]
+
+static Backend Make(int index) {
+    Backend backend;
+    ParseBackend("10.0." + std::to_string(index / 256) + "." + std::to_string(index % 256) + ":4433", backend);
+    return backend;
+}
+
+int main(int argc, char* argv[]) {
+    const int maxBackends = argc > 1 ? std::atoi(argv[1]) : 64;
+    const size_t keys = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 100000;
+    const size_t lookups = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 10000000;
+    if (maxBackends < 2 || keys == 0 || lookups == 0) {
+        std::cerr << "Usage: bench_routing [max_backends] [keys] [lookups]" << std::endl;
+        return 1;
+    }
+
+    std::vector<std::string> robots(keys);
+    for (size_t k = 0; k < keys; ++k) {
+        robots[k] = "robot-" + std::to_string(k);
+    }
+
+    std::cout << std::setw(9) << "backends" << std::setw(12) << "ns/route" << std::setw(15) << "ns/snapshot+"
+              << std::setw(12) << "max share" << std::setw(12) << "moved" << std::setw(12) << "ideal" << std::endl;
+    for (int n = 2; n <= maxBackends; n *= 2) {
+        BackendPool pool;
+        for (int b = 0; b < n; ++b) {
+            pool.add(Make(b));
+        }
+        std::shared_ptr<const HashRing> ring = pool.ring();
+
+        uint64_t checksum = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < lookups; ++i) {
+            checksum += ring->route(robots[i % keys])->port;
+        }
+        double routeNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / lookups;
+
+        start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < lookups; ++i) {
+            checksum += pool.ring()->route(robots[i % keys])->port;
+        }
+        double snapshotNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / lookups;
+
+        // Balance, and movement when backend n joins
+        std::vector<const Backend*> owner(keys);
+        std::vector<size_t> load(n);
+        for (size_t k = 0; k < keys; ++k) {
+            owner[k] = ring->route(robots[k]);
+            ++load[owner[k] - ring->members().data()];
+        }
+        size_t busiest = 0;
+        for (size_t l : load) {
+            busiest = l > busiest ? l : busiest;
+        }
+        pool.add(Make(n));
+        std::shared_ptr<const HashRing> grown = pool.ring();
+        size_t moved = 0;
+        for (size_t k = 0; k < keys; ++k) {
+            moved += grown->route(robots[k])->name != owner[k]->name;
+        }
+
+        std::cout << std::setw(9) << n << std::fixed << std::setprecision(1)
+                  << std::setw(12) << routeNs << std::setw(15) << snapshotNs
+                  << std::setw(11) << 100.0 * busiest / keys << "%"
+                  << std::setw(11) << 100.0 * moved / keys << "%"
+                  << std::setw(11) << 100.0 / (n + 1) << "%" << std::endl;
+        if (checksum == 0) {
+            std::cerr << "Routing failed" << std::endl;
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,147 @@
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "server.h"
+#include "client.h"
+
+// Server throughput against the number of msquic workers. The worker layout
+// is process-wide and fixed once msquic starts, so every run forks a fresh
+// server process with N workers on processors 0..N-1 and a separate client
+// process whose connections all send commands as fast as they can. The
+// server has journaling off, so the numbers are for the transport and the
+// handoff to the control thread, not the disk.
+// Usage: bench_scaling [max_workers] [clients] [messages_per_client]
+
+struct RunResult {
+    uint64_t received;
+    double seconds;
+};
+
+static const uint16_t BenchPort = 4533;
+
+// Runs in the server process: reports once every command has arrived
+static void ServeRun(uint32_t workers, uint64_t expected, int ready, int done) {
+    ServerOptions options;
+    options.listen = {{"127.0.0.1", BenchPort}};
+    options.workers = workers;
+    options.journalDirectory.clear();
+    QuicServer server(options);
+    server.SetVerbose(false);
+    char status = server.Initialize() && server.Start() ? 1 : 0;
+    if (write(ready, &status, 1) != 1 || !status) {
+        _exit(1);
+    }
+
+    // Time from the first command to the last, so connection setup is not counted
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(120);
+    while (server.GetCommandsReceived() == 0 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    auto start = std::chrono::steady_clock::now();
+    while (server.GetCommandsReceived() < expected && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    RunResult result{server.GetCommandsReceived(),
+                     std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()};
+    bool reported = write(done, &result, sizeof(result)) == sizeof(result);
+    _exit(reported ? 0 : 1);
+}
+
+// Runs in the client process
+static void SendRun(uint32_t clients, uint64_t messages) {
+    std::vector<std::thread> threads;
+    for (uint32_t c = 0; c < clients; ++c) {
+        threads.emplace_back([messages]() {
+            QuicClient client;
+            if (!client.Initialize() || !client.Connect("127.0.0.1", BenchPort)) {
+                return;
+            }
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+            while (!client.IsConnected() && std::chrono::steady_clock::now() < deadline) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            for (uint64_t sent = 0; sent < messages && client.IsConnected(); ) {
+                if (client.SendControlCommand(0.5f, 0.0f)) {
+                    ++sent;
+                } else {
+                    // All send buffers are in flight; let msquic drain them
+                    std::this_thread::yield();
+                }
+            }
+            // Keep the connection open until the server has had time to read everything
+            std::this_thread::sleep_for(std::chrono::seconds(2));
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    _exit(0);
+}
+
+static bool RunWorkers(uint32_t workers, uint32_t clients, uint64_t messages, RunResult& result) {
+    int ready[2];
+    int done[2];
+    if (pipe(ready) != 0 || pipe(done) != 0) {
+        return false;
+    }
+    pid_t server = fork();
+    if (server == 0) {
+        ServeRun(workers, clients * messages, ready[1], done[1]);
+    }
+    char status = 0;
+    if (server < 0 || read(ready[0], &status, 1) != 1 || !status) {
+        return false;
+    }
+    pid_t sender = fork();
+    if (sender == 0) {
+        SendRun(clients, messages);
+    }
+    bool ok = sender > 0 && read(done[0], &result, sizeof(result)) == sizeof(result);
+    waitpid(server, nullptr, 0);
+    if (sender > 0) {
+        waitpid(sender, nullptr, 0);
+    }
+    for (int fd : {ready[0], ready[1], done[0], done[1]}) {
+        close(fd);
+    }
+    return ok;
+}
+
+int main(int argc, char* argv[]) {
+    const uint32_t maxWorkers = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : std::thread::hardware_concurrency();
+    const uint32_t clients = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 16;
+    const uint64_t messages = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 50000;
+    if (maxWorkers == 0 || clients == 0 || messages == 0) {
+        std::cerr << "Usage: bench_scaling [max_workers] [clients] [messages_per_client]" << std::endl;
+        return 1;
+    }
+
+    std::cout << clients << " clients x " << messages << " commands over 127.0.0.1" << std::endl;
+    // Powers of two, then the maximum itself
+    std::vector<uint32_t> steps;
+    for (uint32_t workers = 1; workers < maxWorkers; workers *= 2) {
+        steps.push_back(workers);
+    }
+    steps.push_back(maxWorkers);
+
+    double baseline = 0;
+    for (uint32_t workers : steps) {
+        RunResult result{};
+        if (!RunWorkers(workers, clients, messages, result)) {
+            std::cerr << workers << " workers: run failed" << std::endl;
+            return 1;
+        }
+        double rate = result.received / result.seconds;
+        if (workers == 1) {
+            baseline = rate;
+        }
+        std::cout << workers << " workers: " << static_cast<uint64_t>(rate) << " msg/s ("
+                  << result.received << " in " << result.seconds << " s, "
+                  << (baseline > 0 ? rate / baseline : 0.0) << "x)" << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,57 @@
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include "features.h"
+
+// Cost of the dead-man watchdog on the control thread: every session sends
+// commands at a fixed rate and each one re-arms its timer. Time is simulated
+// millisecond by millisecond, so the run takes only as long as the work.
+// Halfway through, 1% of the sessions go silent and must expire.
+// Usage: bench_watchdog [sessions] [rate_hz] [seconds]
+
+int main(int argc, char* argv[]) {
+    const uint32_t sessions = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 10000;
+    const uint32_t rate = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 100;
+    const uint32_t seconds = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 10;
+    if (sessions == 0 || rate == 0 || rate > 1000 || seconds == 0) {
+        std::cerr << "Usage: bench_watchdog [sessions] [rate_hz <= 1000] [seconds]" << std::endl;
+        return 1;
+    }
+    const uint32_t periodMs = 1000 / rate;
+    const uint64_t durationMs = seconds * 1000ull;
+
+    DeadmanWatchdog watchdog(sessions);
+    const uint64_t start = DeadmanWatchdog::clockMs();
+    uint64_t feeds = 0;
+    uint64_t expired = 0;
+    std::chrono::nanoseconds feedTime{0};
+    std::chrono::nanoseconds expireTime{0};
+
+    for (uint64_t ms = 0; ms < durationMs; ++ms) {
+        uint64_t now = start + ms;
+        bool silence = ms >= durationMs / 2;
+
+        // Sessions are spread evenly over the period, as independent clients would be
+        auto begin = std::chrono::steady_clock::now();
+        for (uint32_t session = static_cast<uint32_t>(ms % periodMs); session < sessions; session += periodMs) {
+            if (silence && session % 100 == 0) {
+                continue;
+            }
+            watchdog.feed(session, 0, now);
+            ++feeds;
+        }
+        auto middle = std::chrono::steady_clock::now();
+        expired += watchdog.expire(now, [](uint32_t, uint32_t) {});
+        auto end = std::chrono::steady_clock::now();
+        feedTime += middle - begin;
+        expireTime += end - middle;
+    }
+
+    double busy = std::chrono::duration<double>(feedTime + expireTime).count();
+    std::cout << sessions << " sessions at " << rate << " Hz for " << seconds << " s: "
+              << feeds << " re-arms, " << expired << " expired" << std::endl;
+    std::cout << "Re-arm: " << static_cast<double>(feedTime.count()) / feeds << " ns each; "
+              << "expiry scan: " << static_cast<double>(expireTime.count()) / durationMs << " ns per ms" << std::endl;
+    std::cout << "Control thread busy " << 100.0 * busy / seconds << "% of one core" << std::endl;
+    return 0;
+}
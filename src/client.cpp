@@ -1,214 +1,103 @@
 #include <iostream>
-#include <memory>
-#include <thread>
 #include <chrono>
-#include "msquic.h"
-#include "teleop_generated.h"
-
-class QuicClient {
-private:
-    const QUIC_API_TABLE* MsQuic;
-    HQUIC Registration;
-    HQUIC Connection;
-    bool Running;
-
-    static QUIC_STATUS QUIC_API ClientCallback(
-        HQUIC Connection,
-        void* Context,
-        QUIC_CONNECTION_EVENT* Event) {
-        auto client = static_cast<QuicClient*>(Context);
-        return client->HandleConnectionEvent(Connection, Event);
-    }
-
-    QUIC_STATUS HandleConnectionEvent(HQUIC Connection, QUIC_CONNECTION_EVENT* Event) {
-        switch (Event->Type) {
-            case QUIC_CONNECTION_EVENT_CONNECTED:
-                std::cout << "Connected to server" << std::endl;
-                std::cout << "  ALPN: " << std::string((const char*)Event->CONNECTED.NegotiatedAlpn, 
-                                                     Event->CONNECTED.NegotiatedAlpnLength) << std::endl;
-                std::cout << "  Session resumed: " << (Event->CONNECTED.SessionResumed ? "yes" : "no") << std::endl;
-                return QUIC_STATUS_SUCCESS;
-
-            case QUIC_CONNECTION_EVENT_SHUTDOWN_INITIATED_BY_TRANSPORT:
-                std::cout << "Transport shutdown with status: 0x" << std::hex << Event->SHUTDOWN_INITIATED_BY_TRANSPORT.Status 
-                          << ", error code: 0x" << Event->SHUTDOWN_INITIATED_BY_TRANSPORT.ErrorCode << std::dec << std::endl;
-                return QUIC_STATUS_SUCCESS;
-
-            case QUIC_CONNECTION_EVENT_SHUTDOWN_INITIATED_BY_PEER:
-                std::cout << "Peer shutdown with error code: 0x" << std::hex 
-                          << Event->SHUTDOWN_INITIATED_BY_PEER.ErrorCode << std::dec << std::endl;
-                return QUIC_STATUS_SUCCESS;
-
-            case QUIC_CONNECTION_EVENT_SHUTDOWN_COMPLETE:
-                std::cout << "Connection shutdown complete" << std::endl;
-                Running = false;
-                return QUIC_STATUS_SUCCESS;
-
-            case QUIC_CONNECTION_EVENT_STREAMS_AVAILABLE:
-                std::cout << "Streams available" << std::endl;
-                return QUIC_STATUS_SUCCESS;
-
-            case QUIC_CONNECTION_EVENT_PEER_NEEDS_STREAMS:
-                std::cout << "Peer needs streams" << std::endl;
-                return QUIC_STATUS_SUCCESS;
-                
-            case QUIC_CONNECTION_EVENT_PEER_STREAM_STARTED:
-                std::cout << "Peer stream started" << std::endl;
-                return QUIC_STATUS_SUCCESS;
-                
-            case QUIC_CONNECTION_EVENT_DATAGRAM_STATE_CHANGED:
-                std::cout << "Datagram state changed" << std::endl;
-                return QUIC_STATUS_SUCCESS;
-                
-            case QUIC_CONNECTION_EVENT_RESUMED:
-                std::cout << "Connection resumed" << std::endl;
-                return QUIC_STATUS_SUCCESS;
-                
-            default:
-                std::cout << "Unknown event: " << Event->Type << std::endl;
-                return QUIC_STATUS_SUCCESS;
-        }
-    }
-
-public:
-    QuicClient() : Running(false) {
-        MsQuic = nullptr;
-        Registration = nullptr;
-        Connection = nullptr;
-    }
-
-    bool Initialize() {
-        if (QUIC_FAILED(MsQuicOpen2(&MsQuic))) {
-            std::cerr << "Failed to open MsQuic" << std::endl;
-            return false;
-        }
-
-        QUIC_REGISTRATION_CONFIG RegConfig = {
-            "TeleopClient",
-            QUIC_EXECUTION_PROFILE_LOW_LATENCY
-        };
-
-        if (QUIC_FAILED(MsQuic->RegistrationOpen(&RegConfig, &Registration))) {
-            std::cerr << "Failed to open registration" << std::endl;
-            return false;
-        }
-
-        return true;
-    }
-
-    bool Connect(const char* ServerName) {
-        if (QUIC_FAILED(MsQuic->ConnectionOpen(Registration, ClientCallback, this, &Connection))) {
-            std::cerr << "Failed to open connection" << std::endl;
-            return false;
-        }
-
-        // Setup ALPN buffer
-        const char* alpnStr = "teleop";
-        QUIC_BUFFER alpn;
-        alpn.Buffer = (uint8_t*)alpnStr;
-        alpn.Length = (uint32_t)strlen(alpnStr);
-
-        // Create a configuration for the connection
-        HQUIC Configuration = nullptr;
-        QUIC_SETTINGS Settings = {0};
-        
-        // Set SendBufferingEnabled flag in IsSetFlags and set it to true
-        Settings.IsSet.SendBufferingEnabled = 1;
-        Settings.SendBufferingEnabled = 1;
-        
-        // Customize other settings for better logging
-        Settings.IsSet.KeepAliveIntervalMs = 1;
-        Settings.KeepAliveIntervalMs = 1000; // Send keep-alive every second
-        
-        Settings.IsSet.DisconnectTimeoutMs = 1;
-        Settings.DisconnectTimeoutMs = 30000; // 30 seconds disconnect timeout
-        
-        std::cout << "Creating configuration with ALPN: " << alpnStr << std::endl;
-        if (QUIC_FAILED(MsQuic->ConfigurationOpen(Registration, &alpn, 1, &Settings, sizeof(Settings), nullptr, &Configuration))) {
-            std::cerr << "Failed to open configuration" << std::endl;
-            return false;
-        }
-
-        // Disable certificate validation for testing
-        QUIC_CREDENTIAL_CONFIG CredConfig;
-        memset(&CredConfig, 0, sizeof(CredConfig));
-        CredConfig.Type = QUIC_CREDENTIAL_TYPE_NONE;
-        CredConfig.Flags = QUIC_CREDENTIAL_FLAG_CLIENT | QUIC_CREDENTIAL_FLAG_NO_CERTIFICATE_VALIDATION;
-
-        std::cout << "Loading credentials" << std::endl;
-        if (QUIC_FAILED(MsQuic->ConfigurationLoadCredential(Configuration, &CredConfig))) {
-            std::cerr << "Failed to load credentials" << std::endl;
-            MsQuic->ConfigurationClose(Configuration);
-            return false;
-        }
-        
-        std::cout << "Connecting to server: " << ServerName << std::endl;
-        if (QUIC_FAILED(MsQuic->ConnectionStart(Connection, Configuration, QUIC_ADDRESS_FAMILY_INET, ServerName, 4433))) {
-            std::cerr << "Failed to start connection" << std::endl;
-            MsQuic->ConfigurationClose(Configuration);
+#include <cstring>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include "client.h"
+
+// Polls until Done holds or Timeout passes
+template <typename Condition>
+static bool WaitFor(Condition done, std::chrono::seconds timeout) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (!done()) {
+        if (std::chrono::steady_clock::now() >= deadline) {
             return false;
         }
-
-        // Close the configuration as we don't need it anymore
-        MsQuic->ConfigurationClose(Configuration);
-
-        Running = true;
-        return true;
-    }
-
-    void SendControlCommand(float linear_velocity, float angular_velocity) {
-        flatbuffers::FlatBufferBuilder builder;
-        auto timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
-            std::chrono::system_clock::now().time_since_epoch()).count();
-
-        auto command = Teleop::CreateControlCommand(
-            builder,
-            linear_velocity,
-            angular_velocity,
-            timestamp
-        );
-        builder.Finish(command);
-
-        // TODO: Send the serialized command over QUIC
-        // This would involve creating a stream and sending the data
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
     }
+    return true;
+}
 
-    void Run() {
-        while (Running) {
-            // Example: Send a control command every 100ms
-            SendControlCommand(0.5f, 0.0f); // Move forward
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+int main(int argc, char* argv[]) {
+    CommandTransport transport = CommandTransport::Stream;
+    RateLoopOptions loopOptions;
+    bool duplicateStops = false;
+    uint16_t port = 4433;
+    TransportProfiles profiles;
+    std::string tuning = "default";
+    std::string clientId;
+    std::string robotId;
+    bool validArgs = argc >= 2;
+    for (int i = 2; validArgs && i < argc; ++i) {
+        if (strcmp(argv[i], "--datagram") == 0) {
+            transport = CommandTransport::Datagram;
+        } else if (strcmp(argv[i], "--stream-per-message") == 0) {
+            transport = CommandTransport::StreamPerMessage;
+        } else if (strcmp(argv[i], "--duplicate-stops") == 0) {
+            duplicateStops = true;
+        } else if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            int value = std::atoi(argv[++i]);
+            port = static_cast<uint16_t>(value);
+            validArgs = value > 0 && value <= 65535;
+        } else if (strcmp(argv[i], "--tuning") == 0 && i + 1 < argc) {
+            tuning = argv[++i];
+        } else if (strcmp(argv[i], "--tuning-file") == 0 && i + 1 < argc) {
+            std::string error;
+            validArgs = profiles.loadFile(argv[++i], error);
+            if (!validArgs) {
+                std::cerr << error << std::endl;
+            }
+        } else if (strcmp(argv[i], "--client-id") == 0 && i + 1 < argc) {
+            clientId = argv[++i];
+        } else if (strcmp(argv[i], "--robot-id") == 0 && i + 1 < argc) {
+            robotId = argv[++i];
+        } else if (strcmp(argv[i], "--rate") == 0 && i + 1 < argc) {
+            loopOptions.rateHz = std::atof(argv[++i]);
+            validArgs = loopOptions.rateHz > 0 && loopOptions.rateHz <= 10000;
+        } else if (strcmp(argv[i], "--cpu") == 0 && i + 1 < argc) {
+            loopOptions.cpu = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--fifo") == 0 && i + 1 < argc) {
+            loopOptions.fifoPriority = std::atoi(argv[++i]);
+        } else {
+            validArgs = false;
         }
     }
-
-    ~QuicClient() {
-        if (Connection) {
-            MsQuic->ConnectionClose(Connection);
-        }
-        if (Registration) {
-            MsQuic->RegistrationClose(Registration);
-        }
-        if (MsQuic) {
-            MsQuicClose(MsQuic);
-        }
+    // Authenticating with the proxy needs both ids
+    validArgs = validArgs && clientId.empty() == robotId.empty();
+    if (!validArgs) {
+        std::cerr << "Usage: " << argv[0]
+                  << " <server_name> [--port <n>] [--datagram | --stream-per-message] [--duplicate-stops] [--rate <hz>] [--cpu <n>] [--fifo <priority>]"
+                  << " [--tuning <profile>] [--tuning-file <file>] [--client-id <id> --robot-id <id>]" << std::endl;
+        return 1;
     }
-};
-
-int main(int argc, char* argv[]) {
-    if (argc != 2) {
-        std::cerr << "Usage: " << argv[0] << " <server_name>" << std::endl;
+    const TransportProfile* profile = profiles.find(tuning);
+    if (!profile) {
+        std::cerr << "Unknown transport profile " << tuning << std::endl;
         return 1;
     }
 
-    QuicClient client;
+    QuicClient client(transport);
+    client.SetDuplicateStops(duplicateStops);
+    client.SetTransportProfile(*profile);
     if (!client.Initialize()) {
         return 1;
     }
 
-    if (!client.Connect(argv[1])) {
+    if (!client.Connect(argv[1], port)) {
         return 1;
     }
 
-    client.Run();
+    // Behind a proxy, commands only get through with the token it issues
+    if (!clientId.empty()) {
+        if (!WaitFor([&client]() { return client.IsConnected(); }, std::chrono::seconds(10)) ||
+            !client.Authenticate(clientId, robotId) ||
+            !WaitFor([&client]() { return client.IsAuthenticated(); }, std::chrono::seconds(10))) {
+            std::cerr << "Could not authenticate as " << clientId << " for " << robotId << std::endl;
+            return 1;
+        }
+    }
+
+    client.Run(loopOptions);
     return 0;
 } 
\ No newline at end of file
@@ -0,0 +1,619 @@
+#ifndef CLIENT_H
+#define CLIENT_H
+
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <cstring>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include "msquic.h"
+#include "teleop_generated.h"
+#include "envelope.h"
+#include "send_buffer.h"
+#include "framing.h"
+#include "rate_loop.h"
+#include "clock_sync.h"
+#include "histogram.h"
+#include "transport_profile.h"
+#include "log.h"
+
+// How control commands are carried to the server. Stream uses one long-lived
+// stream of length-prefixed frames; StreamPerMessage opens a stream for each
+// command and is kept for comparison. Datagrams are unreliable and never
+// retransmitted, which suits setpoints that are superseded every tick.
+enum class CommandTransport {
+    Stream,
+    StreamPerMessage,
+    Datagram
+};
+
+// Send priorities (QUIC_PARAM_STREAM_PRIORITY) of the client's streams; msquic
+// sends queued data of a higher priority stream first. The default is 0x7FFF.
+namespace StreamPriority {
+constexpr uint16_t Stop = 0xFFFF;
+constexpr uint16_t Command = 0x7FFF;
+constexpr uint16_t Telemetry = 0x0000;
+}
+
+class QuicClient {
+private:
+    const QUIC_API_TABLE* MsQuic;
+    HQUIC Registration;
+    HQUIC Connection;
+    bool Running;
+    CommandTransport Transport;
+    std::atomic<uint32_t> SequenceNumber;
+    bool DuplicateStops;
+
+    // QUIC settings of the connection
+    TransportProfile Tuning;
+
+    // Extra bytes carried by every MOVE command, for benchmarks
+    size_t CommandPadding{0};
+
+    // Command send to echo receive time, when the server echoes commands
+    LatencyHistogram RoundTrip;
+
+    // Long-lived command stream carrying framed messages
+    HQUIC CommandStream;
+
+    // STOP and EMERGENCY_STOP travel on their own highest-priority stream, so
+    // they never wait behind commands or telemetry queued on other streams
+    HQUIC StopStream;
+
+    // Bulk sensor data, sent at the lowest priority
+    HQUIC TelemetryStream;
+
+    // Guards the stream handles above and AuthStream against their
+    // SHUTDOWN_COMPLETE on the msquic worker; senders hold it across StreamSend
+    std::mutex StreamLock;
+
+    // Datagram state reported by msquic on its worker thread
+    std::atomic<bool> Connected;
+    std::atomic<bool> DatagramSendEnabled;
+    std::atomic<uint16_t> DatagramMaxSendLength;
+
+    // Reusable builders; a buffer returns to the pool once msquic is done with it
+    SendBufferPool SendBuffers;
+
+    // Reserved for stops, so a backlog of other sends cannot exhaust them
+    SendBufferPool StopBuffers{8};
+
+    // Proxy authentication. The token is written once on the msquic worker
+    // before Authenticated is set, and only read after it is.
+    std::string ClientId;
+    std::string AuthToken;
+    std::atomic<bool> Authenticated{false};
+    HQUIC AuthStream{nullptr};      // the stream the request went out on, and the reply comes back on
+    FrameDecoder AuthDecoder;
+
+    static QUIC_STATUS QUIC_API StreamCallback(
+        HQUIC Stream,
+        void* Context,
+        QUIC_STREAM_EVENT* Event) {
+        auto client = static_cast<QuicClient*>(Context);
+        return client->HandleStreamEvent(Stream, Event);
+    }
+
+    QUIC_STATUS HandleStreamEvent(HQUIC Stream, QUIC_STREAM_EVENT* Event) {
+        switch (Event->Type) {
+            case QUIC_STREAM_EVENT_RECEIVE: {
+                // Only the proxy answers on a client stream
+                bool auth;
+                {
+                    std::lock_guard<std::mutex> guard(StreamLock);
+                    auth = Stream == AuthStream;
+                }
+                if (auth) {
+                    uint64_t receivedUs = SystemTimeUs();
+                    for (uint32_t i = 0; i < Event->RECEIVE.BufferCount; ++i) {
+                        AuthDecoder.feed(Event->RECEIVE.Buffers[i].Buffer, Event->RECEIVE.Buffers[i].Length,
+                            [this, receivedUs](const uint8_t* Data, size_t Length) {
+                                const Teleop::Envelope* envelope = OpenEnvelope(Data, Length);
+                                if (!envelope || !GetDispatcher().dispatch(*this, envelope, receivedUs)) {
+                                    LOG_WARN("Dropping unexpected stream message ({} bytes)", Length);
+                                }
+                            });
+                    }
+                }
+                return QUIC_STATUS_SUCCESS;
+            }
+
+            case QUIC_STREAM_EVENT_SEND_COMPLETE:
+                // release() only touches the buffer, so this also returns stop buffers
+                SendBuffers.release(static_cast<SendBuffer*>(Event->SEND_COMPLETE.ClientContext));
+                return QUIC_STATUS_SUCCESS;
+
+            case QUIC_STREAM_EVENT_SHUTDOWN_COMPLETE: {
+                // No sender can reach the handle once it is cleared under the lock
+                std::lock_guard<std::mutex> guard(StreamLock);
+                if (Stream == CommandStream) {
+                    CommandStream = nullptr;
+                } else if (Stream == StopStream) {
+                    StopStream = nullptr;
+                } else if (Stream == TelemetryStream) {
+                    TelemetryStream = nullptr;
+                }
+                if (Stream == AuthStream) {
+                    AuthStream = nullptr;
+                }
+                MsQuic->StreamClose(Stream);
+                return QUIC_STATUS_SUCCESS;
+            }
+
+            default:
+                return QUIC_STATUS_SUCCESS;
+        }
+    }
+
+    using Dispatcher = MessageDispatcher<QuicClient, uint64_t>;
+
+    // Payload types the client accepts from the server
+    static const Dispatcher& GetDispatcher() {
+        static const Dispatcher dispatcher = Dispatcher()
+            .on(Teleop::Payload_TimeSync,
+                [](QuicClient& client, const Teleop::Envelope* envelope, uint64_t receivedUs) {
+                    client.HandleTimeSync(envelope->payload_as_TimeSync(), receivedUs);
+                })
+            .on(Teleop::Payload_AuthResponse,
+                [](QuicClient& client, const Teleop::Envelope* envelope, uint64_t) {
+                    client.HandleAuthResponse(envelope->payload_as_AuthResponse());
+                });
+        return dispatcher;
+    }
+
+    void HandleAuthResponse(const Teleop::AuthResponse* response) {
+        if (!response->success() || !response->auth_token()) {
+            LOG_WARN("Authentication refused: {}",
+                     response->error_message() ? response->error_message()->c_str() : "no reason given");
+            return;
+        }
+        if (!Authenticated) {
+            AuthToken = response->auth_token()->str();
+            Authenticated.store(true, std::memory_order_release);
+            LOG_INFO("Authenticated as {}", ClientId);
+        }
+    }
+
+    // Echoes a clock sync request with this host's receive and transmit times.
+    // A message that already carries a receive time is the server's echo of
+    // one of our commands instead (ServerOptions::echoCommands).
+    void HandleTimeSync(const Teleop::TimeSync* request, uint64_t receivedUs) {
+        if (request->receive_us()) {
+            if (receivedUs >= request->origin_us()) {
+                RoundTrip.record(receivedUs - request->origin_us());
+            }
+            return;
+        }
+        SendBuffer* buffer = SendBuffers.acquire();
+        if (!buffer) {
+            return;
+        }
+        auto reply = Teleop::CreateTimeSync(buffer->Builder, request->origin_us(), receivedUs, SystemTimeUs());
+        FinishEnvelope(buffer->Builder, reply);
+        if (QUIC_FAILED(MsQuic->DatagramSend(Connection, buffer->seal(), 1, QUIC_SEND_FLAG_NONE, buffer))) {
+            SendBuffers.release(buffer);
+        }
+    }
+
+    // Opens and starts a long-lived stream with the given send priority; the
+    // handle is published under StreamLock only once the stream has started
+    bool OpenStream(HQUIC& Target, uint16_t Priority, const char* Name) {
+        HQUIC Stream = nullptr;
+        if (QUIC_FAILED(MsQuic->StreamOpen(Connection, QUIC_STREAM_OPEN_FLAG_NONE, StreamCallback, this, &Stream))) {
+            LOG_ERROR("Failed to open {} stream", Name);
+            return false;
+        }
+        if (QUIC_FAILED(MsQuic->SetParam(Stream, QUIC_PARAM_STREAM_PRIORITY, sizeof(Priority), &Priority))) {
+            LOG_WARN("Failed to set {} stream priority", Name);
+        }
+        if (QUIC_FAILED(MsQuic->StreamStart(Stream, QUIC_STREAM_START_FLAG_NONE))) {
+            LOG_ERROR("Failed to start {} stream", Name);
+            MsQuic->StreamClose(Stream);
+            return false;
+        }
+        std::lock_guard<std::mutex> guard(StreamLock);
+        Target = Stream;
+        return true;
+    }
+
+    // Serializes a command into the buffer and returns its send time
+    uint64_t BuildCommand(SendBuffer* buffer, Teleop::CommandType type, float linear_velocity,
+                          float angular_velocity, uint32_t sequence) {
+        flatbuffers::Offset<flatbuffers::String> client_id;
+        flatbuffers::Offset<flatbuffers::String> auth_token;
+        if (Authenticated.load(std::memory_order_acquire)) {
+            client_id = buffer->Builder.CreateString(ClientId);
+            auth_token = buffer->Builder.CreateString(AuthToken);
+        }
+        flatbuffers::Offset<flatbuffers::Vector<uint8_t>> padding;
+        if (CommandPadding && type == Teleop::CommandType_MOVE) {
+            uint8_t* bytes = nullptr;
+            padding = buffer->Builder.CreateUninitializedVector(CommandPadding, &bytes);
+            memset(bytes, 0, CommandPadding);
+        }
+        uint64_t sentUs = SystemTimeUs();
+        auto command = Teleop::CreateControlCommand(
+            buffer->Builder,
+            type,
+            linear_velocity,
+            angular_velocity,
+            0,
+            sentUs / 1000,
+            sequence,
+            client_id,
+            auth_token,
+            sentUs,
+            padding
+        );
+        FinishEnvelope(buffer->Builder, command);
+        return sentUs;
+    }
+
+    static QUIC_STATUS QUIC_API ClientCallback(
+        HQUIC Connection,
+        void* Context,
+        QUIC_CONNECTION_EVENT* Event) {
+        auto client = static_cast<QuicClient*>(Context);
+        return client->HandleConnectionEvent(Connection, Event);
+    }
+
+    QUIC_STATUS HandleConnectionEvent(HQUIC Connection, QUIC_CONNECTION_EVENT* Event) {
+        switch (Event->Type) {
+            case QUIC_CONNECTION_EVENT_CONNECTED:
+                LOG_INFO("Connected to server (ALPN: {}, session resumed: {})",
+                         LogString((const char*)Event->CONNECTED.NegotiatedAlpn, Event->CONNECTED.NegotiatedAlpnLength),
+                         Event->CONNECTED.SessionResumed ? "yes" : "no");
+                Connected = true;
+                return QUIC_STATUS_SUCCESS;
+
+            case QUIC_CONNECTION_EVENT_SHUTDOWN_INITIATED_BY_TRANSPORT:
+                LOG_INFO("Transport shutdown with status: {}, error code: {}",
+                         LogHex(Event->SHUTDOWN_INITIATED_BY_TRANSPORT.Status),
+                         LogHex(Event->SHUTDOWN_INITIATED_BY_TRANSPORT.ErrorCode));
+                return QUIC_STATUS_SUCCESS;
+
+            case QUIC_CONNECTION_EVENT_SHUTDOWN_INITIATED_BY_PEER:
+                LOG_INFO("Peer shutdown with error code: {}", LogHex(Event->SHUTDOWN_INITIATED_BY_PEER.ErrorCode));
+                return QUIC_STATUS_SUCCESS;
+
+            case QUIC_CONNECTION_EVENT_SHUTDOWN_COMPLETE:
+                LOG_INFO("Connection shutdown complete");
+                Connected = false;
+                Running = false;
+                return QUIC_STATUS_SUCCESS;
+
+            case QUIC_CONNECTION_EVENT_STREAMS_AVAILABLE:
+                LOG_DEBUG("Streams available");
+                return QUIC_STATUS_SUCCESS;
+
+            case QUIC_CONNECTION_EVENT_PEER_NEEDS_STREAMS:
+                LOG_DEBUG("Peer needs streams");
+                return QUIC_STATUS_SUCCESS;
+                
+            case QUIC_CONNECTION_EVENT_PEER_STREAM_STARTED:
+                LOG_DEBUG("Peer stream started");
+                return QUIC_STATUS_SUCCESS;
+                
+            case QUIC_CONNECTION_EVENT_DATAGRAM_STATE_CHANGED:
+                LOG_INFO("Datagram state changed: send {}, max length {}",
+                         Event->DATAGRAM_STATE_CHANGED.SendEnabled ? "enabled" : "disabled",
+                         Event->DATAGRAM_STATE_CHANGED.MaxSendLength);
+                DatagramMaxSendLength = Event->DATAGRAM_STATE_CHANGED.MaxSendLength;
+                DatagramSendEnabled = Event->DATAGRAM_STATE_CHANGED.SendEnabled;
+                return QUIC_STATUS_SUCCESS;
+
+            case QUIC_CONNECTION_EVENT_DATAGRAM_RECEIVED: {
+                uint64_t receivedUs = SystemTimeUs();
+                const Teleop::Envelope* envelope = OpenEnvelope(
+                    Event->DATAGRAM_RECEIVED.Buffer->Buffer, Event->DATAGRAM_RECEIVED.Buffer->Length);
+                if (!envelope || !GetDispatcher().dispatch(*this, envelope, receivedUs)) {
+                    LOG_WARN("Dropping unexpected datagram ({} bytes)", Event->DATAGRAM_RECEIVED.Buffer->Length);
+                }
+                return QUIC_STATUS_SUCCESS;
+            }
+
+            case QUIC_CONNECTION_EVENT_DATAGRAM_SEND_STATE_CHANGED:
+                // Lost datagrams are deliberately not resent; the next tick supersedes them
+                if (QUIC_DATAGRAM_SEND_STATE_IS_FINAL(Event->DATAGRAM_SEND_STATE_CHANGED.State)) {
+                    SendBuffers.release(static_cast<SendBuffer*>(Event->DATAGRAM_SEND_STATE_CHANGED.ClientContext));
+                }
+                return QUIC_STATUS_SUCCESS;
+                
+            case QUIC_CONNECTION_EVENT_RESUMED:
+                LOG_INFO("Connection resumed");
+                return QUIC_STATUS_SUCCESS;
+                
+            default:
+                LOG_DEBUG("Unknown event: {}", Event->Type);
+                return QUIC_STATUS_SUCCESS;
+        }
+    }
+
+public:
+    explicit QuicClient(CommandTransport transport = CommandTransport::Stream)
+        : Running(false), Transport(transport), SequenceNumber(0), DuplicateStops(false),
+          CommandStream(nullptr), StopStream(nullptr), TelemetryStream(nullptr),
+          Connected(false), DatagramSendEnabled(false), DatagramMaxSendLength(0) {
+        MsQuic = nullptr;
+        Registration = nullptr;
+        Connection = nullptr;
+    }
+
+    bool Initialize() {
+        if (QUIC_FAILED(MsQuicOpen2(&MsQuic))) {
+            LOG_ERROR("Failed to open MsQuic");
+            return false;
+        }
+
+        QUIC_REGISTRATION_CONFIG RegConfig = {
+            "TeleopClient",
+            QUIC_EXECUTION_PROFILE_LOW_LATENCY
+        };
+
+        if (QUIC_FAILED(MsQuic->RegistrationOpen(&RegConfig, &Registration))) {
+            LOG_ERROR("Failed to open registration");
+            return false;
+        }
+
+        return true;
+    }
+
+    // Takes effect on the next Connect()
+    void SetTransportProfile(const TransportProfile& profile) { Tuning = profile; }
+
+    bool Connect(const char* ServerName, uint16_t Port = 4433) {
+        if (QUIC_FAILED(MsQuic->ConnectionOpen(Registration, ClientCallback, this, &Connection))) {
+            LOG_ERROR("Failed to open connection");
+            return false;
+        }
+
+        // Setup ALPN buffer
+        const char* alpnStr = "teleop";
+        QUIC_BUFFER alpn;
+        alpn.Buffer = (uint8_t*)alpnStr;
+        alpn.Length = (uint32_t)strlen(alpnStr);
+
+        // Create a configuration for the connection
+        HQUIC Configuration = nullptr;
+        QUIC_SETTINGS Settings = {0};
+        Tuning.apply(Settings);
+
+        // Negotiate the DATAGRAM extension so commands can skip retransmission
+        Settings.IsSet.DatagramReceiveEnabled = 1;
+        Settings.DatagramReceiveEnabled = 1;
+        
+        LOG_INFO("Creating configuration with ALPN: {}, transport profile {}", alpnStr, Tuning.name);
+        if (QUIC_FAILED(MsQuic->ConfigurationOpen(Registration, &alpn, 1, &Settings, sizeof(Settings), nullptr, &Configuration))) {
+            LOG_ERROR("Failed to open configuration");
+            return false;
+        }
+
+        // Disable certificate validation for testing
+        QUIC_CREDENTIAL_CONFIG CredConfig;
+        memset(&CredConfig, 0, sizeof(CredConfig));
+        CredConfig.Type = QUIC_CREDENTIAL_TYPE_NONE;
+        CredConfig.Flags = QUIC_CREDENTIAL_FLAG_CLIENT | QUIC_CREDENTIAL_FLAG_NO_CERTIFICATE_VALIDATION;
+
+        LOG_INFO("Loading credentials");
+        if (QUIC_FAILED(MsQuic->ConfigurationLoadCredential(Configuration, &CredConfig))) {
+            LOG_ERROR("Failed to load credentials");
+            MsQuic->ConfigurationClose(Configuration);
+            return false;
+        }
+        
+        LOG_INFO("Connecting to server: {}:{}", ServerName, Port);
+        if (QUIC_FAILED(MsQuic->ConnectionStart(Connection, Configuration, QUIC_ADDRESS_FAMILY_UNSPEC, ServerName, Port))) {
+            LOG_ERROR("Failed to start connection");
+            MsQuic->ConfigurationClose(Configuration);
+            return false;
+        }
+
+        // Close the configuration as we don't need it anymore
+        MsQuic->ConfigurationClose(Configuration);
+
+        // Open the long-lived streams up front; they start once the handshake completes
+        if (Transport != CommandTransport::StreamPerMessage &&
+            !OpenStream(CommandStream, StreamPriority::Command, "command")) {
+            return false;
+        }
+        if (!OpenStream(StopStream, StreamPriority::Stop, "stop") ||
+            !OpenStream(TelemetryStream, StreamPriority::Telemetry, "telemetry")) {
+            return false;
+        }
+
+        Running = true;
+        return true;
+    }
+
+    bool IsConnected() const { return Connected; }
+
+    // Asks the proxy for a token, sent with every later command. The proxy
+    // also routes the connection to the server that owns robotId. Call once
+    // connected and wait for IsAuthenticated(); a server ignores the request.
+    bool Authenticate(const std::string& clientId, const std::string& robotId) {
+        std::lock_guard<std::mutex> guard(StreamLock);
+        HQUIC Stream = CommandStream ? CommandStream : StopStream;
+        if (!Connected || !Stream || AuthStream) {
+            return false;
+        }
+        SendBuffer* buffer = SendBuffers.acquire();
+        if (!buffer) {
+            return false;
+        }
+        ClientId = clientId;
+        AuthStream = Stream;
+        auto request = Teleop::CreateAuthRequest(
+            buffer->Builder,
+            buffer->Builder.CreateString(clientId),
+            buffer->Builder.CreateString(robotId),
+            0,
+            SystemTimeUs() / 1000);
+        FinishEnvelope(buffer->Builder, request);
+        if (QUIC_FAILED(MsQuic->StreamSend(Stream, buffer->sealFramed(), 2, QUIC_SEND_FLAG_NONE, buffer))) {
+            SendBuffers.release(buffer);
+            AuthStream = nullptr;
+            return false;
+        }
+        return true;
+    }
+
+    bool IsAuthenticated() const { return Authenticated.load(std::memory_order_acquire); }
+
+    // Also send every stop as a datagram. Whichever copy arrives first is
+    // applied; the server drops the other as a duplicate.
+    void SetDuplicateStops(bool duplicate) { DuplicateStops = duplicate; }
+    // Pads every MOVE command with this many bytes; call before sending
+    void SetCommandPadding(size_t bytes) { CommandPadding = bytes; }
+    const LatencyHistogram& GetRoundTrip() const { return RoundTrip; }
+
+    // Returns false if the command could not be handed to msquic
+    bool SendControlCommand(float linear_velocity, float angular_velocity) {
+        if (!Connected) {
+            return false;
+        }
+
+        SendBuffer* buffer = SendBuffers.acquire();
+        if (!buffer) {
+            // Every buffer is still in flight; this setpoint is superseded by the next tick anyway
+            return false;
+        }
+
+        BuildCommand(buffer, Teleop::CommandType_MOVE, linear_velocity, angular_velocity, ++SequenceNumber);
+
+        // Fall back to the stream when datagrams were not negotiated or the command does not fit
+        if (Transport == CommandTransport::Datagram &&
+            DatagramSendEnabled &&
+            buffer->Builder.GetSize() <= DatagramMaxSendLength) {
+            if (QUIC_FAILED(MsQuic->DatagramSend(Connection, buffer->seal(), 1, QUIC_SEND_FLAG_NONE, buffer))) {
+                LOG_ERROR("Failed to send command datagram");
+                SendBuffers.release(buffer);
+                return false;
+            }
+            return true;
+        }
+
+        QUIC_BUFFER* frame = buffer->sealFramed();
+
+        if (Transport == CommandTransport::StreamPerMessage) {
+            HQUIC Stream = nullptr;
+            if (QUIC_FAILED(MsQuic->StreamOpen(Connection, QUIC_STREAM_OPEN_FLAG_NONE, StreamCallback, this, &Stream))) {
+                LOG_ERROR("Failed to open command stream");
+                SendBuffers.release(buffer);
+                return false;
+            }
+            if (QUIC_FAILED(MsQuic->StreamSend(Stream, frame, 2, QUIC_SEND_FLAG_START | QUIC_SEND_FLAG_FIN, buffer))) {
+                LOG_ERROR("Failed to send command on stream");
+                SendBuffers.release(buffer);
+                MsQuic->StreamClose(Stream);
+                return false;
+            }
+            return true;
+        }
+
+        std::lock_guard<std::mutex> guard(StreamLock);
+        HQUIC Stream = CommandStream;
+        if (!Stream || QUIC_FAILED(MsQuic->StreamSend(Stream, frame, 2, QUIC_SEND_FLAG_NONE, buffer))) {
+            LOG_ERROR("Failed to send command on stream");
+            SendBuffers.release(buffer);
+            return false;
+        }
+        return true;
+    }
+
+    // Sends STOP or EMERGENCY_STOP on the stop stream, marked as priority
+    // work so msquic schedules it ahead of the connection's other pending
+    // sends, and optionally duplicates it as a priority datagram. Safe to
+    // call from any thread. Returns false if no copy could be handed to msquic.
+    bool SendStop(Teleop::CommandType type = Teleop::CommandType_EMERGENCY_STOP) {
+        if (!Connected) {
+            return false;
+        }
+        uint32_t sequence = ++SequenceNumber;
+        bool sent = false;
+
+        SendBuffer* buffer = StopBuffers.acquire();
+        if (buffer) {
+            std::lock_guard<std::mutex> guard(StreamLock);
+            HQUIC Stream = StopStream;
+            if (Stream) {
+                BuildCommand(buffer, type, 0.0f, 0.0f, sequence);
+                sent = QUIC_SUCCEEDED(MsQuic->StreamSend(Stream, buffer->sealFramed(), 2, QUIC_SEND_FLAG_PRIORITY_WORK, buffer));
+            }
+        }
+        if (buffer && !sent) {
+            StopBuffers.release(buffer);
+        }
+
+        if (DuplicateStops && DatagramSendEnabled) {
+            SendBuffer* copy = StopBuffers.acquire();
+            if (copy) {
+                BuildCommand(copy, type, 0.0f, 0.0f, sequence);
+                if (copy->Builder.GetSize() <= DatagramMaxSendLength &&
+                    QUIC_SUCCEEDED(MsQuic->DatagramSend(Connection, copy->seal(), 1,
+                                                        QUIC_SEND_FLAG_PRIORITY_WORK | QUIC_SEND_FLAG_DGRAM_PRIORITY, copy))) {
+                    sent = true;
+                } else {
+                    StopBuffers.release(copy);
+                }
+            }
+        }
+        if (!sent) {
+            LOG_ERROR("{} could not be sent", Teleop::EnumNameCommandType(type));
+        }
+        return sent;
+    }
+
+    // Sends a position report on the low-priority telemetry stream
+    bool SendSensorData(float x, float y, float battery_level) {
+        if (!Connected) {
+            return false;
+        }
+        SendBuffer* buffer = SendBuffers.acquire();
+        if (!buffer) {
+            return false;
+        }
+        uint64_t sentUs = SystemTimeUs();
+        auto position = Teleop::CreateVector2D(buffer->Builder, x, y);
+        auto data = Teleop::CreateSensorData(
+            buffer->Builder, Teleop::SensorType_POSITION, position, 0, battery_level, 0.0f, 0, 0, sentUs / 1000);
+        FinishEnvelope(buffer->Builder, data);
+        std::lock_guard<std::mutex> guard(StreamLock);
+        HQUIC Stream = TelemetryStream;
+        if (!Stream || QUIC_FAILED(MsQuic->StreamSend(Stream, buffer->sealFramed(), 2, QUIC_SEND_FLAG_NONE, buffer))) {
+            SendBuffers.release(buffer);
+            return false;
+        }
+        return true;
+    }
+
+    void Run(const RateLoopOptions& options = RateLoopOptions()) {
+        RateLoop loop(options);
+        loop.configureThread();
+        loop.start();
+        while (Running) {
+            // Example: Send a move command every period
+            SendControlCommand(0.5f, 0.0f); // Move forward
+            loop.wait();
+        }
+        loop.printStats(std::cout);
+    }
+
+    ~QuicClient() {
+        if (Connection) {
+            MsQuic->ConnectionClose(Connection);
+        }
+        if (Registration) {
+            MsQuic->RegistrationClose(Registration);
+        }
+        if (MsQuic) {
+            MsQuicClose(MsQuic);
+        }
+    }
+};
+
+#endif // CLIENT_H
@@ -0,0 +1,125 @@
+#ifndef CLOCK_SYNC_H
+#define CLOCK_SYNC_H
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// Wall-clock time in microseconds since the epoch, the unit of every
+// timestamp exchanged for latency and clock sync
+inline uint64_t SystemTimeUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// Estimates a peer's clock offset and drift from NTP-style four-timestamp
+// exchanges: t1 (local send), t2 (peer receive), t3 (peer send) and t4 (local
+// receive), all in microseconds. For each exchange
+//   offset = ((t2 - t1) + (t3 - t4)) / 2   (peer clock minus local clock)
+//   delay  = (t4 - t1) - (t3 - t2)
+// The offset error is bounded by delay / 2, so of the last FilterSize samples
+// the one with the smallest delay is trusted (the NTP clock filter). Drift is
+// the least-squares slope of those filtered offsets over time, clamped to
+// +/-500 ppm, and is used to extrapolate between exchanges.
+//
+// Not thread-safe: msquic delivers all events of a connection on one worker,
+// so a per-connection instance is only touched from that thread.
+class ClockSync {
+public:
+    static constexpr size_t FilterSize = 8;
+    static constexpr size_t DriftWindow = 32;
+    static constexpr double MaxDriftPpm = 500.0;
+
+    // Returns false for samples that cannot be valid (timestamps out of order)
+    bool addSample(uint64_t t1, uint64_t t2, uint64_t t3, uint64_t t4) {
+        if (t4 < t1 || t3 < t2 || (t3 - t2) > (t4 - t1)) {
+            ++rejected;
+            return false;
+        }
+        Sample sample;
+        sample.offset = (static_cast<int64_t>(t2 - t1) + (static_cast<int64_t>(t3) - static_cast<int64_t>(t4))) / 2;
+        sample.delay = static_cast<int64_t>((t4 - t1) - (t3 - t2));
+        sample.time = t4;
+        filter[samples % FilterSize] = sample;
+        ++samples;
+
+        const Sample* best = &filter[0];
+        size_t filled = samples < FilterSize ? samples : FilterSize;
+        for (size_t i = 1; i < filled; ++i) {
+            if (filter[i].delay < best->delay) {
+                best = &filter[i];
+            }
+        }
+        if (estimates == 0 || best->time != current.time) {
+            current = *best;
+            history[estimates % DriftWindow] = current;
+            ++estimates;
+            updateDrift();
+        }
+        return true;
+    }
+
+    bool synced() const { return samples > 0; }
+
+    // Peer clock minus local clock at the given local time
+    int64_t offsetAt(uint64_t localUs) const {
+        if (!synced()) {
+            return 0;
+        }
+        double elapsed = static_cast<double>(static_cast<int64_t>(localUs - current.time));
+        return current.offset + static_cast<int64_t>(drift * elapsed);
+    }
+
+    // Converts a peer timestamp into the local timebase
+    uint64_t toLocal(uint64_t peerUs, uint64_t localNowUs) const {
+        return peerUs - static_cast<uint64_t>(offsetAt(localNowUs));
+    }
+
+    int64_t offset() const { return current.offset; }
+    int64_t delay() const { return current.delay; }
+    double driftPpm() const { return drift * 1e6; }
+    uint64_t sampleCount() const { return samples; }
+    uint64_t rejectedCount() const { return rejected; }
+
+private:
+    struct Sample {
+        int64_t offset{0};
+        int64_t delay{0};
+        uint64_t time{0};
+    };
+
+    std::array<Sample, FilterSize> filter{};
+    std::array<Sample, DriftWindow> history{};
+    Sample current;
+    uint64_t samples{0};
+    uint64_t estimates{0};
+    uint64_t rejected{0};
+    double drift{0.0};  // seconds per second
+
+    void updateDrift() {
+        size_t n = estimates < DriftWindow ? estimates : DriftWindow;
+        if (n < 2) {
+            return;
+        }
+        // Least squares over (time, offset), relative to the newest point for precision
+        double sumX = 0, sumY = 0, sumXX = 0, sumXY = 0;
+        for (size_t i = 0; i < n; ++i) {
+            double x = static_cast<double>(static_cast<int64_t>(history[i].time - current.time));
+            double y = static_cast<double>(history[i].offset - current.offset);
+            sumX += x;
+            sumY += y;
+            sumXX += x * x;
+            sumXY += x * y;
+        }
+        double denominator = n * sumXX - sumX * sumX;
+        if (denominator <= 0) {
+            return;
+        }
+        double slope = (n * sumXY - sumX * sumY) / denominator;
+        double limit = MaxDriftPpm / 1e6;
+        drift = slope > limit ? limit : (slope < -limit ? -limit : slope);
+    }
+};
+
+#endif // CLOCK_SYNC_H
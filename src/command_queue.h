@@ -0,0 +1,310 @@
+#ifndef COMMAND_QUEUE_H
+#define COMMAND_QUEUE_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#ifdef __linux__
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#include "bounded_queue.h"
+#include "teleop_generated.h"
+
+// Plain copy of the fields of a ControlCommand the control loop acts on.
+// Unlike ControlCommandT it owns no heap memory, so it can be handed between
+// threads without allocating.
+struct ControlSetpoint {
+    Teleop::CommandType type;
+    bool hasTarget;
+    float linearVelocity;
+    float angularVelocity;
+    float targetX;
+    float targetY;
+    uint32_t sequence;
+    uint64_t sentUs;      // sender's timestamp, in the receiver's timebase
+    uint64_t receivedUs;
+    uint32_t mailbox;     // connection (mailbox) it arrived on
+    uint32_t generation;
+
+    static ControlSetpoint from(const Teleop::ControlCommand* command) {
+        ControlSetpoint setpoint{};
+        setpoint.type = command->command_type();
+        setpoint.linearVelocity = command->linear_velocity();
+        setpoint.angularVelocity = command->angular_velocity();
+        if (auto target = command->target_position()) {
+            setpoint.hasTarget = true;
+            setpoint.targetX = target->x();
+            setpoint.targetY = target->y();
+        }
+        setpoint.sequence = command->sequence_number();
+        return setpoint;
+    }
+
+    // Commands that must reach the control loop even if newer ones follow
+    bool isUrgent() const {
+        return type == Teleop::CommandType_STOP || type == Teleop::CommandType_EMERGENCY_STOP;
+    }
+};
+
+// Wakes a parked consumer without taking a lock on the producer side. The
+// producer only makes a syscall when the consumer is actually asleep.
+class WakeSignal {
+    std::atomic<uint32_t> epoch{0};
+    std::atomic<bool> sleeping{false};
+public:
+    void notify() {
+        epoch.fetch_add(1, std::memory_order_seq_cst);
+        if (sleeping.load(std::memory_order_seq_cst)) {
+#ifdef __linux__
+            syscall(SYS_futex, reinterpret_cast<uint32_t*>(&epoch), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+#endif
+        }
+    }
+
+    uint32_t prepare() const { return epoch.load(std::memory_order_seq_cst); }
+
+    // Sleeps until notify() is called after prepare() returned `seen`, or the timeout
+    void wait(uint32_t seen, std::chrono::nanoseconds timeout) {
+        sleeping.store(true, std::memory_order_seq_cst);
+        if (epoch.load(std::memory_order_seq_cst) == seen) {
+#ifdef __linux__
+            struct timespec ts;
+            ts.tv_sec = static_cast<time_t>(timeout.count() / 1000000000);
+            ts.tv_nsec = static_cast<long>(timeout.count() % 1000000000);
+            syscall(SYS_futex, reinterpret_cast<uint32_t*>(&epoch), FUTEX_WAIT_PRIVATE, seen, &ts, nullptr, 0);
+#else
+            std::this_thread::sleep_for(std::min<std::chrono::nanoseconds>(timeout, std::chrono::microseconds(100)));
+#endif
+        }
+        sleeping.store(false, std::memory_order_seq_cst);
+    }
+};
+
+// Latest-value slot for one setpoint. A single writer (msquic delivers a
+// connection's events on one worker) publishes under a seqlock; the payload
+// is stored as relaxed atomic words so a concurrent read is well-defined and
+// simply retried if it overlapped a write.
+class SetpointSlot {
+    static_assert(std::is_trivially_copyable<ControlSetpoint>::value, "setpoint must be trivially copyable");
+    static constexpr size_t Words = (sizeof(ControlSetpoint) + 7) / 8;
+
+    std::atomic<uint32_t> version{0};
+    std::atomic<uint64_t> words[Words];
+public:
+    SetpointSlot() {
+        for (auto& word : words) {
+            word.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    void store(const ControlSetpoint& setpoint) {
+        uint64_t raw[Words] = {};
+        memcpy(raw, &setpoint, sizeof(setpoint));
+        uint32_t v = version.load(std::memory_order_relaxed);
+        version.store(v + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < Words; ++i) {
+            words[i].store(raw[i], std::memory_order_relaxed);
+        }
+        version.store(v + 2, std::memory_order_release);
+    }
+
+    void load(ControlSetpoint& setpoint) const {
+        uint64_t raw[Words];
+        for (;;) {
+            uint32_t before = version.load(std::memory_order_acquire);
+            if (before & 1) {
+                continue;
+            }
+            for (size_t i = 0; i < Words; ++i) {
+                raw[i] = words[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (version.load(std::memory_order_relaxed) == before) {
+                break;
+            }
+        }
+        memcpy(&setpoint, raw, sizeof(setpoint));
+    }
+};
+
+// One connection's setpoints, and the stop latched for it when the urgent
+// queue was full
+struct SetpointMailbox {
+    SetpointSlot latest;
+    SetpointSlot stop;
+    std::atomic<bool> queued{false};
+    std::atomic<bool> stopLatched{false};
+    std::atomic<uint32_t> generation{0};
+
+    void store(const ControlSetpoint& setpoint) { latest.store(setpoint); }
+    void load(ControlSetpoint& setpoint) const { latest.load(setpoint); }
+};
+
+// Handoff from msquic receive callbacks to the control thread, with no locks
+// and no allocation on either side after construction.
+//
+// Setpoints (MOVE, CONFIGURE) overwrite the connection's mailbox, so the
+// control thread only ever sees the newest one; a mailbox is put on the ready
+// queue at most once until the control thread picks it up. STOP and
+// EMERGENCY_STOP go through their own queue and are never overwritten; they
+// are drained before any setpoint, and a setpoint that was sent before a stop
+// from the same connection is discarded. If even the urgent queue overflows,
+// the strongest stop is latched in the connection's mailbox and delivered
+// for that connection.
+class CommandQueue {
+    std::vector<SetpointMailbox> mailboxes;
+    BoundedQueue<uint32_t> freeMailboxes;
+    BoundedQueue<uint32_t> ready;
+    BoundedQueue<ControlSetpoint> urgent;
+    BoundedQueue<uint32_t> latched;     // mailboxes with a stop latched, each at most once
+    std::atomic<uint64_t> overwritten{0};
+    WakeSignal signal;
+
+    // Consumer side, per mailbox: newest sequence delivered in its current
+    // generation. Anything not newer is a duplicate or was overtaken by a stop.
+    struct DeliveredMark {
+        uint32_t generation{0};
+        uint32_t sequence{0};
+        bool valid{false};
+
+        bool supersedes(const ControlSetpoint& setpoint) const {
+            return valid && generation == setpoint.generation &&
+                   static_cast<int32_t>(setpoint.sequence - sequence) <= 0;
+        }
+        void advance(const ControlSetpoint& setpoint) {
+            if (!supersedes(setpoint)) {
+                generation = setpoint.generation;
+                sequence = setpoint.sequence;
+                valid = true;
+            }
+        }
+    };
+    std::vector<DeliveredMark> delivered;
+    uint32_t drainEpoch{0};
+
+public:
+    explicit CommandQueue(size_t mailboxCount = 1024, size_t urgentCapacity = 1024)
+        : mailboxes(mailboxCount), freeMailboxes(mailboxCount), ready(mailboxCount),
+          urgent(urgentCapacity), latched(mailboxCount), delivered(mailboxCount) {
+        for (uint32_t i = 0; i < mailboxCount; ++i) {
+            freeMailboxes.push(i);
+        }
+    }
+
+    // Claims a mailbox for a new connection; returns -1 when all are in use
+    int32_t openMailbox() {
+        uint32_t index;
+        if (!freeMailboxes.pop(index)) {
+            return -1;
+        }
+        return static_cast<int32_t>(index);
+    }
+
+    // Invalidates anything still queued from the mailbox and recycles it
+    void closeMailbox(int32_t index) {
+        mailboxes[index].generation.fetch_add(1, std::memory_order_acq_rel);
+        freeMailboxes.push(static_cast<uint32_t>(index));
+    }
+
+    // Called from the connection's worker thread
+    void publish(int32_t index, ControlSetpoint setpoint) {
+        SetpointMailbox& mailbox = mailboxes[index];
+        setpoint.mailbox = static_cast<uint32_t>(index);
+        setpoint.generation = mailbox.generation.load(std::memory_order_acquire);
+        if (setpoint.isUrgent()) {
+            if (!urgent.push(setpoint)) {
+                // Keep the strongest stop, the newest of equals; only this
+                // thread writes the slot, so reading it back is safe
+                ControlSetpoint current;
+                bool pending = mailbox.stopLatched.load(std::memory_order_acquire);
+                if (pending) {
+                    mailbox.stop.load(current);
+                }
+                if (!pending || setpoint.type >= current.type) {
+                    mailbox.stop.store(setpoint);
+                }
+                if (!mailbox.stopLatched.exchange(true, std::memory_order_acq_rel)) {
+                    latched.push(static_cast<uint32_t>(index));
+                }
+            }
+        } else {
+            mailbox.store(setpoint);
+            if (!mailbox.queued.exchange(true, std::memory_order_acq_rel)) {
+                ready.push(static_cast<uint32_t>(index));
+            } else {
+                overwritten.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        signal.notify();
+    }
+
+    // Control thread: delivers pending urgent commands, then the newest
+    // setpoint of every connection that published one. Returns the number
+    // of commands delivered.
+    template <typename Handler>
+    size_t drain(Handler&& handler) {
+        // Anything published from here on wakes the next wait()
+        drainEpoch = signal.prepare();
+        size_t count = 0;
+        ControlSetpoint setpoint;
+        uint32_t index;
+        while (latched.pop(index)) {
+            SetpointMailbox& mailbox = mailboxes[index];
+            // Clear first so a stop latched during the read is queued again
+            mailbox.stopLatched.store(false, std::memory_order_seq_cst);
+            mailbox.stop.load(setpoint);
+            delivered[index].advance(setpoint);
+            handler(setpoint);
+            ++count;
+        }
+        // Stops are never dropped, even if they arrive out of order
+        while (urgent.pop(setpoint)) {
+            delivered[setpoint.mailbox].advance(setpoint);
+            handler(setpoint);
+            ++count;
+        }
+        while (ready.pop(index)) {
+            SetpointMailbox& mailbox = mailboxes[index];
+            // Clear first so a write racing with this read queues the mailbox again
+            mailbox.queued.store(false, std::memory_order_seq_cst);
+            mailbox.load(setpoint);
+            if (setpoint.generation != mailbox.generation.load(std::memory_order_acquire)) {
+                continue;  // connection closed
+            }
+            if (delivered[index].supersedes(setpoint)) {
+                continue;
+            }
+            delivered[index].advance(setpoint);
+            handler(setpoint);
+            ++count;
+        }
+        return count;
+    }
+
+    // Control thread: blocks until something is published after the start of
+    // the last drain(), or the timeout passes
+    void wait(std::chrono::nanoseconds timeout) {
+        signal.wait(drainEpoch, timeout);
+    }
+
+    // Changes whenever the mailbox is closed, so a later owner is told apart
+    uint32_t mailboxGeneration(uint32_t index) const {
+        return mailboxes[index].generation.load(std::memory_order_acquire);
+    }
+    size_t mailboxCount() const { return mailboxes.size(); }
+    uint64_t overwrittenCount() const { return overwritten.load(std::memory_order_relaxed); }
+    // Queue depths, approximate; safe to read from any thread
+    size_t pendingUrgent() const { return urgent.sizeApprox(); }
+    size_t pendingSetpoints() const { return ready.sizeApprox(); }
+};
+
+#endif // COMMAND_QUEUE_H
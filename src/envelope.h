@@ -0,0 +1,67 @@
+#ifndef ENVELOPE_H
+#define ENVELOPE_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include "teleop_generated.h"
+
+// Wire protocol version carried in every Envelope
+constexpr uint16_t ProtocolVersion = 1;
+
+// Wraps a finished payload table in an Envelope and finishes the buffer with
+// the schema's file identifier
+template <typename T>
+void FinishEnvelope(flatbuffers::FlatBufferBuilder& builder, flatbuffers::Offset<T> payload) {
+    auto envelope = Teleop::CreateEnvelope(
+        builder,
+        ProtocolVersion,
+        Teleop::PayloadTraits<T>::enum_value,
+        payload.Union());
+    Teleop::FinishEnvelopeBuffer(builder, envelope);
+}
+
+// Verifies a received message in place. Returns nullptr if the buffer is
+// malformed, lacks the file identifier or was written for another protocol
+// version.
+inline const Teleop::Envelope* OpenEnvelope(const uint8_t* data, size_t length) {
+    flatbuffers::Verifier verifier(data, length);
+    if (!Teleop::VerifyEnvelopeBuffer(verifier)) {
+        return nullptr;
+    }
+    auto envelope = Teleop::GetEnvelope(data);
+    if (envelope->version() != ProtocolVersion) {
+        return nullptr;
+    }
+    return envelope;
+}
+
+// Table of handlers indexed by the Payload union tag, so a verified message
+// is routed with a single lookup instead of trying each root type in turn.
+// Handlers are plain function pointers (captureless lambdas work) taking the
+// owner, the envelope and any extra per-call arguments.
+template <typename Owner, typename... Args>
+class MessageDispatcher {
+public:
+    using Handler = void (*)(Owner&, const Teleop::Envelope*, Args...);
+
+    MessageDispatcher& on(Teleop::Payload type, Handler handler) {
+        handlers[type] = handler;
+        return *this;
+    }
+
+    // Returns false when no handler is registered for the payload type
+    bool dispatch(Owner& owner, const Teleop::Envelope* envelope, Args... args) const {
+        auto type = static_cast<size_t>(envelope->payload_type());
+        if (type >= handlers.size() || !handlers[type]) {
+            return false;
+        }
+        handlers[type](owner, envelope, args...);
+        return true;
+    }
+
+private:
+    std::array<Handler, Teleop::Payload_MAX + 1> handlers{};
+};
+
+#endif // ENVELOPE_H
@@ -2,49 +2,97 @@
 #define FEATURES_H
 
 #include <vector>
-#include <fstream>
+#include <atomic>
 #include <chrono>
+#include "histogram.h"
+#include "timer_wheel.h"
+#include "command_queue.h"
 #include "teleop_generated.h"
 
+// One-way command latency: the receive time minus the sender's timestamp,
+// recorded in microseconds into an HDR histogram. Cheap enough to call on
+// every message from msquic callback threads. Timestamps from another host
+// must first be converted to the local timebase (see ClockSync).
 class LatencyStats {
-    std::chrono::milliseconds total{0};
-    size_t count{0};
+    LatencyHistogram histogram;
+    std::atomic<uint64_t> future{0};
 public:
-    void add(uint64_t sentTs) {
-        auto now = std::chrono::duration_cast<std::chrono::milliseconds>(
-            std::chrono::system_clock::now().time_since_epoch()).count();
-        if (now > sentTs) {
-            total += std::chrono::milliseconds(now - sentTs);
-            ++count;
+    void add(uint64_t sentUs, uint64_t receivedUs) {
+        if (receivedUs >= sentUs) {
+            histogram.record(receivedUs - sentUs);
+        } else {
+            // Sent "after" it arrived: the clocks disagree by more than the latency
+            future.fetch_add(1, std::memory_order_relaxed);
         }
     }
-    double average() const {
-        return count ? static_cast<double>(total.count()) / static_cast<double>(count) : 0.0;
-    }
-};
-
-class CommandLogger {
-    std::ofstream file;
-public:
-    bool open(const std::string& path) {
-        file.open(path, std::ios::app);
-        return file.is_open();
-    }
-    void log(const Teleop::ControlCommandT& cmd) {
-        if (!file.is_open()) return;
-        file << cmd.timestamp << "," << cmd.linear_velocity << "," << cmd.angular_velocity << "\n";
-    }
+    void merge(const LatencyStats& other) { histogram.merge(other.histogram); }
+    LatencySnapshot snapshot() const { return histogram.snapshot(); }
+    LatencySnapshot snapshotAndReset() { return histogram.snapshotAndReset(); }
+    uint64_t futureCount() const { return future.load(std::memory_order_relaxed); }
 };
 
+// Records the commands applied by the control thread. start() and stop()
+// may be called from another thread; read get() only while stopped.
 class MacroRecorder {
-    std::vector<Teleop::ControlCommandT> buffer;
-    bool recording{false};
+    std::vector<ControlSetpoint> buffer;
+    std::atomic<bool> recording{false};
 public:
-    void start() { recording = true; buffer.clear(); }
+    void start() { buffer.clear(); recording = true; }
     void stop() { recording = false; }
-    void record(const Teleop::ControlCommandT& cmd) { if (recording) buffer.push_back(cmd); }
-    const std::vector<Teleop::ControlCommandT>& get() const { return buffer; }
+    void record(const ControlSetpoint& cmd) { if (recording) buffer.push_back(cmd); }
+    const std::vector<ControlSetpoint>& get() const { return buffer; }
     bool isRecording() const { return recording; }
 };
 
+// Dead-man switch for robot sessions: once a session has sent a command, it
+// must send another within the timeout or expire() reports it, once, so the
+// caller can stop the robot. Every command re-arms the session's timer in
+// O(1) on a millisecond timer wheel, so one thread can watch thousands of
+// sessions. Runs on the control thread only.
+class DeadmanWatchdog {
+    TimerWheel wheel;
+    std::vector<uint32_t> generations;
+    uint64_t timeoutMs;
+public:
+    static uint64_t clockMs() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    explicit DeadmanWatchdog(size_t sessions, std::chrono::milliseconds timeout = std::chrono::milliseconds(250))
+        : wheel(sessions, clockMs()), generations(sessions), timeoutMs(timeout.count()) {}
+
+    // A zero timeout turns the watchdog off; sessions already armed are dropped
+    void setTimeout(std::chrono::milliseconds timeout) {
+        timeoutMs = timeout.count();
+        if (!timeoutMs) {
+            for (uint32_t session = 0; session < generations.size(); ++session) {
+                wheel.cancel(session);
+            }
+        }
+    }
+    std::chrono::milliseconds timeout() const { return std::chrono::milliseconds(timeoutMs); }
+
+    // A command arrived; `generation` tells a reused session slot apart
+    void feed(uint32_t session, uint32_t generation, uint64_t nowMs) {
+        if (timeoutMs) {
+            generations[session] = generation;
+            wheel.schedule(session, nowMs + timeoutMs);
+        }
+    }
+
+    void disarm(uint32_t session) { wheel.cancel(session); }
+
+    // Calls onExpire(session, generation) for every session whose deadline
+    // has passed; it stays disarmed until it is fed again
+    template <typename Handler>
+    size_t expire(uint64_t nowMs, Handler&& onExpire) {
+        return wheel.advance(nowMs, [this, &onExpire](uint32_t session) {
+            onExpire(session, generations[session]);
+        });
+    }
+
+    size_t armedCount() const { return wheel.armedCount(); }
+};
+
 #endif // FEATURES_H
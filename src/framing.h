@@ -0,0 +1,124 @@
+#ifndef FRAMING_H
+#define FRAMING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Length-prefixed framing for long-lived streams. Each frame is an unsigned
+// LEB128 varint holding the payload length followed by the payload (one
+// serialized FlatBuffer).
+namespace Framing {
+
+constexpr size_t MaxPrefixLength = 5;
+constexpr size_t DefaultMaxFrameLength = 64 * 1024;
+
+// Writes the varint prefix for a payload of the given length and returns its size
+inline size_t EncodePrefix(uint32_t length, uint8_t* out) {
+    size_t n = 0;
+    while (length >= 0x80) {
+        out[n++] = static_cast<uint8_t>(length | 0x80);
+        length >>= 7;
+    }
+    out[n++] = static_cast<uint8_t>(length);
+    return n;
+}
+
+} // namespace Framing
+
+// Incremental frame decoder. Data can be fed in arbitrary pieces: a frame may
+// span several receive buffers and one buffer may hold several frames. Frames
+// that arrive whole inside one buffer are handed to the callback in place;
+// only frames split across buffers are gathered into the internal buffer,
+// whose capacity is reused between frames.
+class FrameDecoder {
+    enum class State { Prefix, Payload };
+
+    State state{State::Prefix};
+    uint32_t length{0};
+    unsigned shift{0};
+    std::vector<uint8_t> partial;
+    size_t maxLength;
+    bool failed{false};
+
+    // Consumes one prefix byte; returns false on an over-long or oversized prefix
+    bool prefixByte(uint8_t byte) {
+        // The fifth byte holds only the top four bits of a 32-bit length,
+        // and ends the prefix
+        if (shift == 7 * (Framing::MaxPrefixLength - 1) && byte > 0x0f) {
+            return false;
+        }
+        length |= static_cast<uint32_t>(byte & 0x7f) << shift;
+        shift += 7;
+        if (byte & 0x80) {
+            return true;
+        }
+        if (length > maxLength) {
+            return false;
+        }
+        state = State::Payload;
+        partial.clear();
+        return true;
+    }
+
+    void resetPrefix() {
+        state = State::Prefix;
+        length = 0;
+        shift = 0;
+    }
+
+public:
+    explicit FrameDecoder(size_t maxFrameLength = Framing::DefaultMaxFrameLength)
+        : maxLength(maxFrameLength) {}
+
+    // Feeds received bytes, invoking onFrame(const uint8_t*, size_t) for every
+    // complete frame. Returns false once the stream is malformed; the decoder
+    // then ignores further input.
+    template <typename Handler>
+    bool feed(const uint8_t* data, size_t size, Handler&& onFrame) {
+        if (failed) {
+            return false;
+        }
+        size_t pos = 0;
+        while (pos < size) {
+            if (state == State::Prefix) {
+                if (!prefixByte(data[pos++])) {
+                    failed = true;
+                    return false;
+                }
+                if (state == State::Payload && length == 0) {
+                    onFrame(data + pos, 0);
+                    resetPrefix();
+                }
+                continue;
+            }
+
+            size_t available = size - pos;
+            if (partial.empty() && available >= length) {
+                // Whole frame is contiguous in this buffer
+                onFrame(data + pos, length);
+                pos += length;
+                resetPrefix();
+                continue;
+            }
+
+            size_t needed = length - partial.size();
+            size_t take = available < needed ? available : needed;
+            partial.insert(partial.end(), data + pos, data + pos + take);
+            pos += take;
+            if (partial.size() == length) {
+                onFrame(partial.data(), partial.size());
+                partial.clear();
+                resetPrefix();
+            }
+        }
+        return true;
+    }
+
+    // True when no frame is partially received, i.e. the stream may end here
+    bool idle() const { return state == State::Prefix && shift == 0; }
+    bool hasFailed() const { return failed; }
+};
+
+#endif // FRAMING_H
@@ -0,0 +1,197 @@
+#ifndef HASH_RING_H
+#define HASH_RING_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// An upstream server the proxy can route sessions to
+struct Backend {
+    std::string name;   // "host:port"; the ring hashes this, so it must be stable
+    std::string host;
+    uint16_t port{0};
+};
+
+// Parses "host:port" or "[v6-address]:port"
+inline bool ParseBackend(const std::string& text, Backend& backend) {
+    size_t colon = text.rfind(':');
+    if (colon == std::string::npos || colon == 0 || colon + 1 == text.size()) {
+        return false;
+    }
+    std::string host = text.substr(0, colon);
+    if (host.front() == '[') {
+        if (host.size() < 3 || host.back() != ']') {
+            return false;
+        }
+        host = host.substr(1, host.size() - 2);
+    }
+    char* end = nullptr;
+    long port = std::strtol(text.c_str() + colon + 1, &end, 10);
+    if (*end != '\0' || port <= 0 || port > 65535) {
+        return false;
+    }
+    backend.name = text;
+    backend.host = host;
+    backend.port = static_cast<uint16_t>(port);
+    return true;
+}
+
+// Consistent hash ring. Every backend owns a number of points (virtual nodes)
+// on a 64-bit ring, placed by hashing its name, and a key belongs to the
+// first point at or after its own hash. Adding or removing a backend only
+// moves the keys of the points it gains or loses, about 1/n of them, and
+// every other key keeps its backend. A lookup is one hash and a binary search.
+class HashRing {
+    struct Point {
+        uint64_t hash;
+        uint32_t backend;
+        bool operator<(const Point& other) const { return hash < other.hash; }
+    };
+
+    std::vector<Backend> backends;
+    std::vector<Point> points;      // sorted by hash
+    size_t replicas;
+
+    static uint64_t mix(uint64_t x) {
+        // splitmix64 finalizer; spreads FNV's weak low bits over the whole word
+        x ^= x >> 30;
+        x *= 0xbf58476d1ce4e5b9ULL;
+        x ^= x >> 27;
+        x *= 0x94d049bb133111ebULL;
+        x ^= x >> 31;
+        return x;
+    }
+
+    void rebuild() {
+        points.clear();
+        points.reserve(backends.size() * replicas);
+        for (uint32_t b = 0; b < backends.size(); ++b) {
+            uint64_t base = hash(backends[b].name);
+            for (size_t i = 0; i < replicas; ++i) {
+                points.push_back({mix(base ^ (0x9e3779b97f4a7c15ULL * (i + 1))), b});
+            }
+        }
+        std::sort(points.begin(), points.end());
+    }
+
+public:
+    explicit HashRing(size_t virtualNodes = 128) : replicas(virtualNodes) {}
+
+    // FNV-1a with a finalizer
+    static uint64_t hash(std::string_view key) {
+        uint64_t h = 0xcbf29ce484222325ULL;
+        for (char c : key) {
+            h ^= static_cast<uint8_t>(c);
+            h *= 0x100000001b3ULL;
+        }
+        return mix(h);
+    }
+
+    // Returns false if a backend with the same name is already on the ring
+    bool add(const Backend& backend) {
+        for (const Backend& b : backends) {
+            if (b.name == backend.name) {
+                return false;
+            }
+        }
+        backends.push_back(backend);
+        rebuild();
+        return true;
+    }
+
+    bool remove(const std::string& name) {
+        for (size_t b = 0; b < backends.size(); ++b) {
+            if (backends[b].name == name) {
+                backends.erase(backends.begin() + b);
+                rebuild();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // The backend that owns the key; nullptr when the ring is empty
+    const Backend* route(std::string_view key) const {
+        if (points.empty()) {
+            return nullptr;
+        }
+        Point probe{hash(key), 0};
+        auto it = std::lower_bound(points.begin(), points.end(), probe);
+        if (it == points.end()) {
+            it = points.begin();
+        }
+        return &backends[it->backend];
+    }
+
+    // The first backend Accept takes, trying backends in the order their
+    // points follow the key. A key whose owner is skipped always lands on the
+    // same next backend, and keys of backends that are not skipped stay put.
+    // nullptr when Accept takes none.
+    template <typename Accept>
+    const Backend* route(std::string_view key, Accept&& accept) const {
+        if (points.empty()) {
+            return nullptr;
+        }
+        Point probe{hash(key), 0};
+        size_t start = std::lower_bound(points.begin(), points.end(), probe) - points.begin();
+        std::vector<bool> tried(backends.size());
+        size_t untried = backends.size();
+        for (size_t i = 0; i < points.size() && untried; ++i) {
+            uint32_t b = points[(start + i) % points.size()].backend;
+            if (tried[b]) {
+                continue;
+            }
+            tried[b] = true;
+            --untried;
+            if (accept(backends[b])) {
+                return &backends[b];
+            }
+        }
+        return nullptr;
+    }
+
+    const std::vector<Backend>& members() const { return backends; }
+    size_t size() const { return backends.size(); }
+};
+
+// The proxy's backends. Routing reads an immutable ring through
+// std::atomic_load and never waits for a writer; add() and remove() build a new ring and
+// swap it in, so sessions routed before a change keep their backend and
+// lookups already in progress finish on the ring they started with.
+class BackendPool {
+    std::shared_ptr<const HashRing> current;
+    std::mutex writers;
+
+    template <typename Change>
+    bool update(Change&& change) {
+        std::lock_guard<std::mutex> guard(writers);
+        std::shared_ptr<HashRing> next = std::make_shared<HashRing>(*std::atomic_load(&current));
+        if (!change(*next)) {
+            return false;
+        }
+        std::atomic_store(&current, std::shared_ptr<const HashRing>(std::move(next)));
+        return true;
+    }
+
+public:
+    explicit BackendPool(size_t virtualNodes = 128)
+        : current(std::make_shared<HashRing>(virtualNodes)) {}
+
+    bool add(const Backend& backend) {
+        return update([&backend](HashRing& ring) { return ring.add(backend); });
+    }
+
+    bool remove(const std::string& name) {
+        return update([&name](HashRing& ring) { return ring.remove(name); });
+    }
+
+    // Keep the snapshot for as long as a Backend it returned is used
+    std::shared_ptr<const HashRing> ring() const { return std::atomic_load(&current); }
+};
+
+#endif // HASH_RING_H
@@ -0,0 +1,149 @@
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// Percentiles and totals read out of a LatencyHistogram at one point in time
+struct LatencySnapshot {
+    uint64_t count{0};
+    uint64_t p50{0};
+    uint64_t p90{0};
+    uint64_t p99{0};
+    uint64_t p999{0};
+    uint64_t max{0};
+    double mean{0.0};
+};
+
+// HDR-style log-linear histogram of microsecond values. Values below 128 us
+// are counted exactly; above that each power of two is split into 64 buckets,
+// so a reported percentile is within 1/64 (~1.6%) of the true value. Values
+// beyond MaxValue (~134 s) are clamped into the last bucket.
+//
+// Recording is a handful of relaxed atomic adds, safe from any number of
+// threads. Histograms can be merged, and snapshotAndReset() drains counts
+// atomically bucket by bucket, so concurrent records land in either the
+// drained interval or the next one and are never lost.
+class LatencyHistogram {
+public:
+    static constexpr int SubBucketBits = 7;
+    static constexpr uint64_t SubBucketCount = 1ull << SubBucketBits;  // 128
+    static constexpr uint64_t SubBucketHalf = SubBucketCount / 2;      // 64
+    static constexpr int MaxValueBits = 27;
+    static constexpr uint64_t MaxValue = (1ull << MaxValueBits) - 1;
+    static constexpr size_t BucketCount =
+        SubBucketCount + (MaxValueBits - SubBucketBits) * SubBucketHalf;
+
+    static size_t bucketIndex(uint64_t value) {
+        if (value > MaxValue) {
+            value = MaxValue;
+        }
+        if (value < SubBucketCount) {
+            return static_cast<size_t>(value);
+        }
+        int msb = 63 - __builtin_clzll(value);
+        int shift = msb - (SubBucketBits - 1);
+        return static_cast<size_t>(SubBucketCount + (shift - 1) * SubBucketHalf +
+                                   ((value >> shift) - SubBucketHalf));
+    }
+
+    // Largest value that maps to the bucket
+    static uint64_t bucketUpperBound(size_t index) {
+        if (index < SubBucketCount) {
+            return index;
+        }
+        size_t shift = (index - SubBucketCount) / SubBucketHalf + 1;
+        uint64_t sub = (index - SubBucketCount) % SubBucketHalf + SubBucketHalf;
+        return ((sub + 1) << shift) - 1;
+    }
+
+    void record(uint64_t valueUs) {
+        counts[bucketIndex(valueUs)].fetch_add(1, std::memory_order_relaxed);
+        sum.fetch_add(valueUs, std::memory_order_relaxed);
+        uint64_t seen = maximum.load(std::memory_order_relaxed);
+        while (valueUs > seen &&
+               !maximum.compare_exchange_weak(seen, valueUs, std::memory_order_relaxed)) {
+        }
+    }
+
+    // Adds another histogram's counts into this one
+    void merge(const LatencyHistogram& other) {
+        for (size_t i = 0; i < BucketCount; ++i) {
+            uint64_t n = other.counts[i].load(std::memory_order_relaxed);
+            if (n) {
+                counts[i].fetch_add(n, std::memory_order_relaxed);
+            }
+        }
+        sum.fetch_add(other.sum.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        uint64_t otherMax = other.maximum.load(std::memory_order_relaxed);
+        uint64_t seen = maximum.load(std::memory_order_relaxed);
+        while (otherMax > seen &&
+               !maximum.compare_exchange_weak(seen, otherMax, std::memory_order_relaxed)) {
+        }
+    }
+
+    LatencySnapshot snapshot() const {
+        Counts local;
+        for (size_t i = 0; i < BucketCount; ++i) {
+            local[i] = counts[i].load(std::memory_order_relaxed);
+        }
+        return summarize(local, sum.load(std::memory_order_relaxed), maximum.load(std::memory_order_relaxed));
+    }
+
+    // Snapshot of everything recorded since the last reset, then starts a new interval
+    LatencySnapshot snapshotAndReset() {
+        Counts local;
+        for (size_t i = 0; i < BucketCount; ++i) {
+            local[i] = counts[i].exchange(0, std::memory_order_relaxed);
+        }
+        return summarize(local, sum.exchange(0, std::memory_order_relaxed),
+                         maximum.exchange(0, std::memory_order_relaxed));
+    }
+
+    void reset() { snapshotAndReset(); }
+
+private:
+    using Counts = std::array<uint64_t, BucketCount>;
+
+    std::array<std::atomic<uint64_t>, BucketCount> counts{};
+    std::atomic<uint64_t> sum{0};
+    std::atomic<uint64_t> maximum{0};
+
+    static uint64_t bucketLowerBound(size_t index) {
+        return index == 0 ? 0 : bucketUpperBound(index - 1) + 1;
+    }
+
+    static LatencySnapshot summarize(const Counts& local, uint64_t valueSum, uint64_t valueMax) {
+        LatencySnapshot result;
+        size_t highest = 0;
+        for (size_t i = 0; i < BucketCount; ++i) {
+            if (local[i]) {
+                result.count += local[i];
+                highest = i;
+            }
+        }
+        if (result.count == 0) {
+            return result;
+        }
+        // The maximum is updated after the bucket, so it may briefly lag the counts
+        result.max = std::max(valueMax, bucketLowerBound(highest));
+        result.mean = static_cast<double>(valueSum) / static_cast<double>(result.count);
+
+        const double quantiles[] = {0.50, 0.90, 0.99, 0.999};
+        uint64_t* outputs[] = {&result.p50, &result.p90, &result.p99, &result.p999};
+        uint64_t cumulative = 0;
+        size_t q = 0;
+        for (size_t i = 0; i <= highest && q < 4; ++i) {
+            cumulative += local[i];
+            while (q < 4 && static_cast<double>(cumulative) >= quantiles[q] * static_cast<double>(result.count)) {
+                *outputs[q] = std::min(bucketUpperBound(i), result.max);
+                ++q;
+            }
+        }
+        return result;
+    }
+};
+
+#endif // HISTOGRAM_H
@@ -0,0 +1,376 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Append-only binary journal of received messages. Records are copied into a
+// pre-allocated, memory-mapped segment file, so an append is a CRC and a
+// memcpy; a background thread msyncs the dirty range in batches, prepares the
+// next segment ahead of time and finalizes full ones.
+//
+// Segment layout: a 16-byte header ("TLOPJRNL", version) followed by 8-byte
+// aligned records of { length, crc32c, timestampUs, payload }. The CRC covers
+// the timestamp and payload. Unused space is zero, so a zero length marks the
+// end of a segment; a record that is cut short or fails its CRC marks the
+// point a crash tore the tail.
+namespace Journal {
+    constexpr char Magic[8] = {'T', 'L', 'O', 'P', 'J', 'R', 'N', 'L'};
+    constexpr uint32_t Version = 1;
+    constexpr size_t Alignment = 8;
+    constexpr size_t DefaultSegmentSize = 64 * 1024 * 1024;
+
+    struct SegmentHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t reserved;
+    };
+
+    struct RecordHeader {
+        uint32_t length;
+        uint32_t crc;
+        uint64_t timestampUs;
+    };
+
+    // CRC-32C (Castagnoli), chainable by passing the previous result
+    inline uint32_t Crc32c(const uint8_t* data, size_t length, uint32_t crc = 0) {
+        static const std::array<uint32_t, 256> table = [] {
+            std::array<uint32_t, 256> t{};
+            for (uint32_t i = 0; i < 256; ++i) {
+                uint32_t c = i;
+                for (int k = 0; k < 8; ++k) {
+                    c = (c & 1) ? (c >> 1) ^ 0x82F63B78u : (c >> 1);
+                }
+                t[i] = c;
+            }
+            return t;
+        }();
+        crc = ~crc;
+        for (size_t i = 0; i < length; ++i) {
+            crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+        }
+        return ~crc;
+    }
+
+    inline uint32_t RecordCrc(uint64_t timestampUs, const uint8_t* data, size_t length) {
+        return Crc32c(data, length, Crc32c(reinterpret_cast<const uint8_t*>(&timestampUs), sizeof(timestampUs)));
+    }
+
+    inline size_t RecordSize(size_t payloadLength) {
+        return (sizeof(RecordHeader) + payloadLength + Alignment - 1) & ~(Alignment - 1);
+    }
+}
+
+// One mapped segment file. Destroying it syncs the written part, trims the
+// file to it and closes it.
+class JournalSegment {
+public:
+    std::string path;
+    int fd{-1};
+    uint8_t* base{nullptr};
+    size_t size{0};
+    size_t used{0};    // written by appenders under the journal lock
+    size_t synced{0};  // only touched by the sync thread
+
+    static std::shared_ptr<JournalSegment> create(const std::string& path, size_t size) {
+        std::shared_ptr<JournalSegment> segment(new JournalSegment());
+        segment->path = path;
+        segment->size = size;
+        segment->fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (segment->fd < 0) {
+            return nullptr;
+        }
+#ifdef __linux__
+        bool allocated = posix_fallocate(segment->fd, 0, static_cast<off_t>(size)) == 0;
+#else
+        bool allocated = ftruncate(segment->fd, static_cast<off_t>(size)) == 0;
+#endif
+        if (!allocated) {
+            segment->discard();
+            return nullptr;
+        }
+        void* mapped = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, segment->fd, 0);
+        if (mapped == MAP_FAILED) {
+            segment->discard();
+            return nullptr;
+        }
+        segment->base = static_cast<uint8_t*>(mapped);
+
+        Journal::SegmentHeader header{};
+        memcpy(header.magic, Journal::Magic, sizeof(header.magic));
+        header.version = Journal::Version;
+        memcpy(segment->base, &header, sizeof(header));
+        segment->used = sizeof(header);
+        return segment;
+    }
+
+    // Syncs everything written since the last call
+    void sync(size_t end) {
+        if (end <= synced) {
+            return;
+        }
+        static const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        size_t start = synced & ~(pageSize - 1);
+        msync(base + start, end - start, MS_SYNC);
+        synced = end;
+    }
+
+    // Removes a segment that never received records
+    void discard() {
+        if (base) {
+            munmap(base, size);
+            base = nullptr;
+        }
+        if (fd >= 0) {
+            ::close(fd);
+            fd = -1;
+            unlink(path.c_str());
+        }
+    }
+
+    ~JournalSegment() {
+        if (base) {
+            sync(used);
+            munmap(base, size);
+        }
+        if (fd >= 0) {
+            if (ftruncate(fd, static_cast<off_t>(used)) == 0) {
+                fdatasync(fd);
+            }
+            ::close(fd);
+        }
+    }
+
+private:
+    JournalSegment() = default;
+};
+
+class CommandJournal {
+    std::string directory;
+    std::string prefix;
+    size_t segmentSize{Journal::DefaultSegmentSize};
+    std::chrono::milliseconds syncInterval{10};
+
+    std::mutex mutex;
+    std::shared_ptr<JournalSegment> current;
+    std::shared_ptr<JournalSegment> spare;
+    std::vector<std::shared_ptr<JournalSegment>> retired;
+    uint64_t nextIndex{0};
+    bool running{false};
+    std::condition_variable wake;
+    std::thread syncer;
+
+    std::atomic<uint64_t> records{0};
+    std::atomic<uint64_t> failed{0};
+
+    std::string segmentPath(uint64_t index) const {
+        char name[32];
+        snprintf(name, sizeof(name), "-%06llu.journal", static_cast<unsigned long long>(index));
+        return directory + "/" + prefix + name;
+    }
+
+    std::string sparePath() const { return directory + "/" + prefix + ".spare"; }
+
+    // Swaps in the spare segment (or creates one if the sync thread has not
+    // prepared it yet). Called with the lock held.
+    bool rotateLocked() {
+        if (current) {
+            retired.push_back(std::move(current));
+        }
+        std::string path = segmentPath(nextIndex);
+        if (spare && rename(spare->path.c_str(), path.c_str()) == 0) {
+            current = std::move(spare);
+            current->path = path;
+        } else {
+            current = JournalSegment::create(path, segmentSize);
+        }
+        if (!current) {
+            return false;
+        }
+        ++nextIndex;
+        wake.notify_one();
+        return true;
+    }
+
+    void syncLoop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (running) {
+            wake.wait_for(lock, syncInterval);
+
+            std::shared_ptr<JournalSegment> segment = current;
+            size_t end = segment ? segment->used : 0;
+            std::vector<std::shared_ptr<JournalSegment>> full;
+            full.swap(retired);
+            bool needSpare = !spare;
+            lock.unlock();
+
+            // Finalizing and syncing happen without the lock so appends never wait on disk
+            full.clear();
+            if (segment) {
+                segment->sync(end);
+            }
+            if (needSpare) {
+                auto prepared = JournalSegment::create(sparePath(), segmentSize);
+                lock.lock();
+                if (!spare) {
+                    spare = std::move(prepared);
+                }
+                lock.unlock();
+            }
+            segment.reset();
+            lock.lock();
+        }
+    }
+
+public:
+    ~CommandJournal() { close(); }
+
+    // Starts a new segment in `directory` after any existing ones
+    bool open(const std::string& dir, const std::string& name = "commands",
+              size_t segmentBytes = Journal::DefaultSegmentSize,
+              std::chrono::milliseconds interval = std::chrono::milliseconds(10)) {
+        close();
+        directory = dir;
+        prefix = name;
+        segmentSize = segmentBytes;
+        syncInterval = interval;
+
+        nextIndex = 0;
+        struct stat st;
+        while (stat(segmentPath(nextIndex).c_str(), &st) == 0) {
+            ++nextIndex;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!rotateLocked()) {
+            return false;
+        }
+        running = true;
+        syncer = std::thread([this]() { syncLoop(); });
+        return true;
+    }
+
+    // Copies one message into the journal. Safe to call from any thread.
+    bool append(const uint8_t* data, size_t length) {
+        size_t total = Journal::RecordSize(length);
+        if (total > segmentSize - sizeof(Journal::SegmentHeader)) {
+            failed.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        Journal::RecordHeader header;
+        header.length = static_cast<uint32_t>(length);
+        header.timestampUs = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        header.crc = Journal::RecordCrc(header.timestampUs, data, length);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!current || (current->used + total > current->size && !rotateLocked())) {
+            failed.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        uint8_t* record = current->base + current->used;
+        memcpy(record + sizeof(header), data, length);
+        memcpy(record, &header, sizeof(header));
+        current->used += total;
+        records.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Stops the sync thread and finalizes every segment
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!running && !current) {
+                return;
+            }
+            running = false;
+        }
+        wake.notify_one();
+        if (syncer.joinable()) {
+            syncer.join();
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        retired.clear();
+        current.reset();
+        if (spare) {
+            spare->discard();
+            spare.reset();
+        }
+    }
+
+    uint64_t recordCount() const { return records.load(std::memory_order_relaxed); }
+    uint64_t failedCount() const { return failed.load(std::memory_order_relaxed); }
+
+    // Reads a segment file back, calling handler(timestampUs, data, length)
+    // for every intact record. Returns the number of records read; `torn` is
+    // set when the scan stopped at a truncated or corrupt record rather than
+    // the clean end of the segment.
+    static size_t replay(const std::string& path,
+                         const std::function<void(uint64_t, const uint8_t*, size_t)>& handler,
+                         bool* torn = nullptr) {
+        if (torn) {
+            *torn = false;
+        }
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return 0;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(Journal::SegmentHeader)) {
+            ::close(fd);
+            return 0;
+        }
+        size_t size = static_cast<size_t>(st.st_size);
+        void* mapped = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (mapped == MAP_FAILED) {
+            return 0;
+        }
+        const uint8_t* base = static_cast<const uint8_t*>(mapped);
+
+        size_t count = 0;
+        if (memcmp(base, Journal::Magic, sizeof(Journal::Magic)) == 0) {
+            size_t offset = sizeof(Journal::SegmentHeader);
+            while (offset + sizeof(Journal::RecordHeader) <= size) {
+                Journal::RecordHeader header;
+                memcpy(&header, base + offset, sizeof(header));
+                if (header.length == 0 && header.crc == 0) {
+                    break;
+                }
+                size_t total = Journal::RecordSize(header.length);
+                const uint8_t* payload = base + offset + sizeof(header);
+                if (total > size - offset ||
+                    Journal::RecordCrc(header.timestampUs, payload, header.length) != header.crc) {
+                    if (torn) {
+                        *torn = true;
+                    }
+                    break;
+                }
+                handler(header.timestampUs, payload, header.length);
+                ++count;
+                offset += total;
+            }
+        } else if (torn) {
+            *torn = true;
+        }
+        munmap(mapped, size);
+        return count;
+    }
+};
+
+#endif // JOURNAL_H
@@ -0,0 +1,35 @@
+#include <iostream>
+#include "teleop_generated.h"
+#include "envelope.h"
+#include "journal.h"
+
+// Prints the control commands recorded in one or more journal segments
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <segment.journal>..." << std::endl;
+        return 1;
+    }
+
+    std::cout << "received_us,client_id,sequence,type,linear_velocity,angular_velocity,timestamp_ms" << std::endl;
+    for (int i = 1; i < argc; ++i) {
+        bool torn = false;
+        CommandJournal::replay(argv[i], [](uint64_t receivedUs, const uint8_t* data, size_t length) {
+            const Teleop::Envelope* envelope = OpenEnvelope(data, length);
+            const Teleop::ControlCommand* command = envelope ? envelope->payload_as_ControlCommand() : nullptr;
+            if (!command) {
+                return;
+            }
+            std::cout << receivedUs << ","
+                      << (command->client_id() ? command->client_id()->str() : "") << ","
+                      << command->sequence_number() << ","
+                      << Teleop::EnumNameCommandType(command->command_type()) << ","
+                      << command->linear_velocity() << ","
+                      << command->angular_velocity() << ","
+                      << command->timestamp() << "\n";
+        }, &torn);
+        if (torn) {
+            std::cerr << argv[i] << ": stopped at a torn or corrupt record" << std::endl;
+        }
+    }
+    return 0;
+}
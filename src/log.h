@@ -0,0 +1,310 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Asynchronous logging for msquic callbacks and other latency-sensitive
+// threads. A log call copies its arguments into a fixed-size binary record in
+// a lock-free ring owned by the calling thread; a background thread formats
+// the records and writes them out. Producers never block on I/O: when a ring
+// is full the record is dropped and counted.
+//
+// Messages use "{}" placeholders filled in order from the arguments, e.g.
+//   LOG_INFO("Peer shutdown with error code: {}", LogHex(code));
+//
+// Levels below TELEOP_LOG_LEVEL compile to nothing.
+
+#define TELEOP_LOG_LEVEL_TRACE 0
+#define TELEOP_LOG_LEVEL_DEBUG 1
+#define TELEOP_LOG_LEVEL_INFO 2
+#define TELEOP_LOG_LEVEL_WARN 3
+#define TELEOP_LOG_LEVEL_ERROR 4
+
+#ifndef TELEOP_LOG_LEVEL
+#define TELEOP_LOG_LEVEL TELEOP_LOG_LEVEL_INFO
+#endif
+
+enum class LogLevel : uint8_t {
+    Trace = TELEOP_LOG_LEVEL_TRACE,
+    Debug = TELEOP_LOG_LEVEL_DEBUG,
+    Info = TELEOP_LOG_LEVEL_INFO,
+    Warn = TELEOP_LOG_LEVEL_WARN,
+    Error = TELEOP_LOG_LEVEL_ERROR
+};
+
+// Argument wrappers for values that need special formatting
+struct LogHex {
+    uint64_t value;
+    explicit LogHex(uint64_t v) : value(v) {}
+};
+
+struct LogString {
+    const char* data;
+    size_t length;
+    LogString(const char* d, size_t n) : data(d), length(n) {}
+};
+
+struct LogRecord {
+    static constexpr size_t MaxArgs = 6;
+    static constexpr size_t TextCapacity = 80;
+
+    enum class ArgType : uint8_t { Signed, Unsigned, Double, Hex, Text };
+
+    uint64_t timestampUs;
+    const char* format;   // must be a string literal
+    uint64_t args[MaxArgs];
+    ArgType types[MaxArgs];
+    LogLevel level;
+    uint8_t argCount;
+    uint8_t textUsed;
+    char text[TextCapacity];  // string arguments, stored as (length, bytes)
+};
+
+// Single-producer single-consumer ring of log records
+class LogRing {
+    static constexpr size_t Capacity = 1024;  // power of two
+    LogRecord records[Capacity];
+    alignas(64) std::atomic<size_t> head{0};  // written by the consumer
+    alignas(64) std::atomic<size_t> tail{0};  // written by the producer
+public:
+    std::atomic<uint64_t> dropped{0};
+
+    LogRecord* claim() {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == Capacity) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        return &records[t & (Capacity - 1)];
+    }
+
+    void publish() {
+        tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    template <typename Fn>
+    size_t drain(Fn&& fn) {
+        size_t h = head.load(std::memory_order_relaxed);
+        size_t t = tail.load(std::memory_order_acquire);
+        for (size_t i = h; i != t; ++i) {
+            fn(records[i & (Capacity - 1)]);
+        }
+        head.store(t, std::memory_order_release);
+        return t - h;
+    }
+};
+
+class Logger {
+    std::mutex registryMutex;  // only taken when a thread logs for the first time
+    std::vector<std::unique_ptr<LogRing>> rings;
+    std::atomic<size_t> ringCount{0};
+    std::atomic<bool> running{true};
+    std::thread writer;
+
+    Logger() : writer([this]() { writerLoop(); }) {}
+
+    LogRing* threadRing() {
+        thread_local LogRing* ring = nullptr;
+        if (!ring) {
+            std::lock_guard<std::mutex> lock(registryMutex);
+            rings.emplace_back(new LogRing());
+            ring = rings.back().get();
+            ringCount.store(rings.size(), std::memory_order_release);
+        }
+        return ring;
+    }
+
+    static void pack(LogRecord& r, int64_t v) { r.types[r.argCount] = LogRecord::ArgType::Signed; r.args[r.argCount++] = static_cast<uint64_t>(v); }
+    static void pack(LogRecord& r, uint64_t v) { r.types[r.argCount] = LogRecord::ArgType::Unsigned; r.args[r.argCount++] = v; }
+    static void pack(LogRecord& r, double v) {
+        r.types[r.argCount] = LogRecord::ArgType::Double;
+        memcpy(&r.args[r.argCount++], &v, sizeof(v));
+    }
+    static void pack(LogRecord& r, LogHex v) { r.types[r.argCount] = LogRecord::ArgType::Hex; r.args[r.argCount++] = v.value; }
+    static void pack(LogRecord& r, LogString v) {
+        size_t room = LogRecord::TextCapacity - r.textUsed;
+        size_t n = room > 0 ? (v.length < room - 1 ? v.length : room - 1) : 0;
+        r.types[r.argCount] = LogRecord::ArgType::Text;
+        r.args[r.argCount++] = r.textUsed;
+        if (room > 0) {
+            r.text[r.textUsed] = static_cast<char>(n);
+            memcpy(r.text + r.textUsed + 1, v.data, n);
+            r.textUsed = static_cast<uint8_t>(r.textUsed + 1 + n);
+        }
+    }
+    static void pack(LogRecord& r, const char* v) { pack(r, LogString(v, v ? strlen(v) : 0)); }
+    static void pack(LogRecord& r, const std::string& v) { pack(r, LogString(v.data(), v.size())); }
+
+    template <typename T>
+    static void packArg(LogRecord& r, const T& v) {
+        if (r.argCount == LogRecord::MaxArgs) {
+            return;
+        }
+        if constexpr (std::is_floating_point<T>::value) {
+            pack(r, static_cast<double>(v));
+        } else if constexpr (std::is_enum<T>::value) {
+            pack(r, static_cast<int64_t>(v));
+        } else if constexpr (std::is_integral<T>::value && std::is_signed<T>::value) {
+            pack(r, static_cast<int64_t>(v));
+        } else if constexpr (std::is_integral<T>::value) {
+            pack(r, static_cast<uint64_t>(v));
+        } else {
+            pack(r, v);
+        }
+    }
+
+    static void formatRecord(const LogRecord& r, std::string& out) {
+        static const char* const levelNames[] = {"TRACE", "DEBUG", "INFO", "WARN", "ERROR"};
+        char prefix[48];
+        snprintf(prefix, sizeof(prefix), "%llu.%06llu [%s] ",
+                 static_cast<unsigned long long>(r.timestampUs / 1000000),
+                 static_cast<unsigned long long>(r.timestampUs % 1000000),
+                 levelNames[static_cast<int>(r.level)]);
+        out += prefix;
+
+        size_t arg = 0;
+        for (const char* p = r.format; *p; ++p) {
+            if (p[0] == '{' && p[1] == '}' && arg < r.argCount) {
+                char value[32];
+                switch (r.types[arg]) {
+                    case LogRecord::ArgType::Signed:
+                        snprintf(value, sizeof(value), "%lld", static_cast<long long>(r.args[arg]));
+                        out += value;
+                        break;
+                    case LogRecord::ArgType::Unsigned:
+                        snprintf(value, sizeof(value), "%llu", static_cast<unsigned long long>(r.args[arg]));
+                        out += value;
+                        break;
+                    case LogRecord::ArgType::Double: {
+                        double d;
+                        memcpy(&d, &r.args[arg], sizeof(d));
+                        snprintf(value, sizeof(value), "%g", d);
+                        out += value;
+                        break;
+                    }
+                    case LogRecord::ArgType::Hex:
+                        snprintf(value, sizeof(value), "0x%llx", static_cast<unsigned long long>(r.args[arg]));
+                        out += value;
+                        break;
+                    case LogRecord::ArgType::Text: {
+                        size_t offset = static_cast<size_t>(r.args[arg]);
+                        if (offset < r.textUsed) {
+                            out.append(r.text + offset + 1, static_cast<uint8_t>(r.text[offset]));
+                        }
+                        break;
+                    }
+                }
+                ++arg;
+                ++p;
+            } else {
+                out += *p;
+            }
+        }
+        out += '\n';
+    }
+
+    void flushRings(std::string& out, std::string& errors) {
+        size_t count = ringCount.load(std::memory_order_acquire);
+        for (size_t i = 0; i < count; ++i) {
+            LogRing* ring;
+            {
+                std::lock_guard<std::mutex> lock(registryMutex);
+                ring = rings[i].get();
+            }
+            ring->drain([&](const LogRecord& r) {
+                formatRecord(r, r.level >= LogLevel::Warn ? errors : out);
+            });
+            uint64_t dropped = ring->dropped.exchange(0, std::memory_order_relaxed);
+            if (dropped) {
+                errors += "[WARN] log ring full, dropped " + std::to_string(dropped) + " records\n";
+            }
+        }
+        if (!out.empty()) {
+            fwrite(out.data(), 1, out.size(), stdout);
+            fflush(stdout);
+            out.clear();
+        }
+        if (!errors.empty()) {
+            fwrite(errors.data(), 1, errors.size(), stderr);
+            errors.clear();
+        }
+    }
+
+    void writerLoop() {
+        std::string out;
+        std::string errors;
+        while (running.load(std::memory_order_acquire)) {
+            flushRings(out, errors);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        flushRings(out, errors);
+    }
+
+public:
+    static Logger& instance() {
+        static Logger logger;
+        return logger;
+    }
+
+    ~Logger() {
+        running.store(false, std::memory_order_release);
+        writer.join();
+    }
+
+    template <typename... Args>
+    void write(LogLevel level, const char* format, const Args&... args) {
+        LogRing* ring = threadRing();
+        LogRecord* r = ring->claim();
+        if (!r) {
+            return;
+        }
+        r->timestampUs = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        r->format = format;
+        r->level = level;
+        r->argCount = 0;
+        r->textUsed = 0;
+        (packArg(*r, args), ...);
+        ring->publish();
+    }
+};
+
+#define TELEOP_LOG(level, ...) Logger::instance().write(level, __VA_ARGS__)
+
+#if TELEOP_LOG_LEVEL <= TELEOP_LOG_LEVEL_TRACE
+#define LOG_TRACE(...) TELEOP_LOG(LogLevel::Trace, __VA_ARGS__)
+#else
+#define LOG_TRACE(...) do {} while (0)
+#endif
+
+#if TELEOP_LOG_LEVEL <= TELEOP_LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...) TELEOP_LOG(LogLevel::Debug, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) do {} while (0)
+#endif
+
+#if TELEOP_LOG_LEVEL <= TELEOP_LOG_LEVEL_INFO
+#define LOG_INFO(...) TELEOP_LOG(LogLevel::Info, __VA_ARGS__)
+#else
+#define LOG_INFO(...) do {} while (0)
+#endif
+
+#if TELEOP_LOG_LEVEL <= TELEOP_LOG_LEVEL_WARN
+#define LOG_WARN(...) TELEOP_LOG(LogLevel::Warn, __VA_ARGS__)
+#else
+#define LOG_WARN(...) do {} while (0)
+#endif
+
+#define LOG_ERROR(...) TELEOP_LOG(LogLevel::Error, __VA_ARGS__)
+
+#endif // LOG_H
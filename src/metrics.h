@@ -0,0 +1,247 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "histogram.h"
+
+// Builds a scrape in the Prometheus text exposition format (version 0.0.4).
+// Every sample of a metric family must follow its family() line before the
+// next family starts.
+class MetricsWriter {
+    std::string out;
+
+    void number(double value) {
+        char text[32];
+        if (std::isfinite(value) && value == std::floor(value) && std::fabs(value) < 9.0e15) {
+            snprintf(text, sizeof(text), "%lld", static_cast<long long>(value));
+        } else {
+            snprintf(text, sizeof(text), "%.9g", value);
+        }
+        out += text;
+    }
+
+public:
+    void family(const char* name, const char* type, const char* help) {
+        out += "# HELP ";
+        out += name;
+        out += ' ';
+        out += help;
+        out += "\n# TYPE ";
+        out += name;
+        out += ' ';
+        out += type;
+        out += '\n';
+    }
+
+    // labels is the inside of the braces, e.g. connection="3"
+    void sample(const char* name, double value, const std::string& labels = std::string()) {
+        out += name;
+        if (!labels.empty()) {
+            out += '{';
+            out += labels;
+            out += '}';
+        }
+        out += ' ';
+        number(value);
+        out += '\n';
+    }
+
+    void counter(const char* name, const char* help, double value) {
+        family(name, "counter", help);
+        sample(name, value);
+    }
+
+    void gauge(const char* name, const char* help, double value) {
+        family(name, "gauge", help);
+        sample(name, value);
+    }
+
+    // A latency histogram as a summary in seconds
+    void summary(const char* name, const char* help, const LatencySnapshot& latency) {
+        family(name, "summary", help);
+        const std::pair<const char*, uint64_t> quantiles[] = {
+            {"0.5", latency.p50}, {"0.9", latency.p90}, {"0.99", latency.p99}, {"0.999", latency.p999}, {"1", latency.max}};
+        for (const auto& quantile : quantiles) {
+            sample(name, quantile.second / 1e6, std::string("quantile=\"") + quantile.first + "\"");
+        }
+        std::string base(name);
+        sample((base + "_sum").c_str(), latency.mean * latency.count / 1e6);
+        sample((base + "_count").c_str(), static_cast<double>(latency.count));
+    }
+
+    const std::string& text() const { return out; }
+};
+
+// Serves metrics over HTTP on a local TCP port and/or a Unix socket
+// (`curl --unix-socket <path> http://localhost/metrics`). Every scrape runs
+// the collector on the exporter's own thread, so the cost of reading and
+// formatting the metrics is paid there; the code being observed only keeps
+// its counters, which are plain atomics. Any GET is answered with the
+// current metrics, one request per connection.
+class MetricsExporter {
+public:
+    using Collector = std::function<void(MetricsWriter&)>;
+
+private:
+    Collector collect;
+    std::vector<int> sockets;
+    std::string unixPath;
+    uint16_t tcpPort{0};
+    std::atomic<bool> running{false};
+    std::atomic<uint64_t> scrapes{0};
+    std::thread thread;
+
+    void serve() {
+        std::vector<pollfd> fds;
+        for (int fd : sockets) {
+            fds.push_back({fd, POLLIN, 0});
+        }
+        while (running.load(std::memory_order_relaxed)) {
+            if (poll(fds.data(), fds.size(), 200) <= 0) {
+                continue;
+            }
+            for (const pollfd& p : fds) {
+                if (!(p.revents & POLLIN)) {
+                    continue;
+                }
+                int client = accept(p.fd, nullptr, nullptr);
+                if (client >= 0) {
+                    respond(client);
+                    close(client);
+                }
+            }
+        }
+    }
+
+    void respond(int client) {
+        // Read the request head; a slow or silent client is given up on
+        timeval timeout{1, 0};
+        setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+        std::string request;
+        char buffer[1024];
+        while (request.find("\r\n\r\n") == std::string::npos && request.size() < 8192) {
+            ssize_t n = recv(client, buffer, sizeof(buffer), 0);
+            if (n <= 0) {
+                return;
+            }
+            request.append(buffer, static_cast<size_t>(n));
+        }
+
+        std::string response;
+        if (request.compare(0, 4, "GET ") != 0) {
+            response = "HTTP/1.1 405 Method Not Allowed\r\nAllow: GET\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+        } else {
+            MetricsWriter writer;
+            collect(writer);
+            scrapes.fetch_add(1, std::memory_order_relaxed);
+            response = "HTTP/1.1 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: " +
+                       std::to_string(writer.text().size()) + "\r\nConnection: close\r\n\r\n" + writer.text();
+        }
+        for (size_t sent = 0; sent < response.size(); ) {
+            ssize_t n = send(client, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0) {
+                return;
+            }
+            sent += static_cast<size_t>(n);
+        }
+    }
+
+    bool addSocket(int fd, const sockaddr* address, socklen_t length) {
+        if (fd < 0) {
+            return false;
+        }
+        if (bind(fd, address, length) != 0 || listen(fd, 16) != 0) {
+            close(fd);
+            return false;
+        }
+        sockets.push_back(fd);
+        return true;
+    }
+
+public:
+    explicit MetricsExporter(Collector collector) : collect(std::move(collector)) {}
+    MetricsExporter(const MetricsExporter&) = delete;
+    MetricsExporter& operator=(const MetricsExporter&) = delete;
+    ~MetricsExporter() { stop(); }
+
+    // Listens on a loopback TCP port; 0 picks a free one (see port())
+    bool listenTcp(uint16_t port, const char* address = "127.0.0.1") {
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        if (inet_pton(AF_INET, address, &addr.sin_addr) != 1) {
+            return false;
+        }
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        int reuse = 1;
+        if (fd >= 0) {
+            setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        }
+        if (!addSocket(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr))) {
+            return false;
+        }
+        socklen_t length = sizeof(addr);
+        getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &length);
+        tcpPort = ntohs(addr.sin_port);
+        return true;
+    }
+
+    // Listens on a Unix socket, replacing a stale one left at the path
+    bool listenUnix(const std::string& path) {
+        sockaddr_un addr{};
+        if (path.size() >= sizeof(addr.sun_path)) {
+            return false;
+        }
+        addr.sun_family = AF_UNIX;
+        memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+        unlink(path.c_str());
+        if (!addSocket(socket(AF_UNIX, SOCK_STREAM, 0), reinterpret_cast<const sockaddr*>(&addr), sizeof(addr))) {
+            return false;
+        }
+        unixPath = path;
+        return true;
+    }
+
+    bool start() {
+        if (sockets.empty() || running.exchange(true)) {
+            return false;
+        }
+        thread = std::thread([this]() { serve(); });
+        return true;
+    }
+
+    void stop() {
+        if (running.exchange(false)) {
+            thread.join();
+        }
+        for (int fd : sockets) {
+            close(fd);
+        }
+        sockets.clear();
+        if (!unixPath.empty()) {
+            unlink(unixPath.c_str());
+            unixPath.clear();
+        }
+    }
+
+    uint16_t port() const { return tcpPort; }
+    uint64_t scrapeCount() const { return scrapes.load(std::memory_order_relaxed); }
+};
+
+#endif // METRICS_H
@@ -0,0 +1,1187 @@
+#ifndef PROXY_H
+#define PROXY_H
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <chrono>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <thread>
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+#include "msquic.h"
+#include "teleop_generated.h"
+#include "send_buffer.h"
+#include "framing.h"
+#include "relay.h"
+#include "envelope.h"
+#include "hash_ring.h"
+#include "backend_health.h"
+#include "replay_window.h"
+#include "signed_token.h"
+#include "transport_profile.h"
+#include "transport_stats.h"
+#include "metrics.h"
+#include "log.h"
+
+#define QUIC_STATUS_ACCESS_DENIED 0x8041000E
+
+class QuicProxy {
+private:
+    const QUIC_API_TABLE* MsQuic;
+    HQUIC Registration;
+    HQUIC Listener;
+    HQUIC ListenerConfig;   // server credential, for accepted client connections
+    HQUIC UpstreamConfig;   // client credential, for the connections to the servers
+    std::atomic<bool> Running;
+
+    // Servers sessions are routed to, on a consistent hash ring keyed by robot_id
+    BackendPool Backends;
+
+    // Backend health from active probes, and how it steers new sessions
+    BackendHealth Health;
+    RoutingPolicy Routing{RoutingPolicy::Affinity};
+
+    // A connection of the proxy's own to one backend, used only for health
+    // probes: a HealthCheck datagram every probe interval, answered by the
+    // server with its load. The prober thread owns it and is the only one to
+    // open its connection; the connection closes itself on SHUTDOWN_COMPLETE.
+    struct Probe {
+        QuicProxy* Proxy;
+        Backend Target;
+        std::mutex Lock;                // guards Connection against its SHUTDOWN_COMPLETE
+        HQUIC Connection{nullptr};
+        bool Retired{false};            // its backend was removed
+        std::atomic<bool> DatagramSendEnabled{false};
+        std::atomic<uint32_t> Pending{0};   // sequence of the unanswered probe, 0 if none
+        uint32_t Sequence{0};           // prober thread only
+        uint64_t SentUs{0};             // prober thread only
+        uint64_t OpenedUs{0};           // prober thread only
+        TransportStats Stats;
+
+        Probe(QuicProxy* proxy, const Backend& target) : Proxy(proxy), Target(target) {}
+    };
+    std::unordered_map<std::string, std::unique_ptr<Probe>> Probes;    // by backend name; prober thread only
+    std::vector<std::unique_ptr<Probe>> RetiredProbes;      // kept until their connection has closed
+    std::thread Prober;
+    std::mutex ProberLock;
+    std::condition_variable ProberWake;
+    bool Probing{false};
+
+    // TLS certificate of the listener; when empty, no credential is loaded (testing only)
+    std::string CertificateFile;
+    std::string PrivateKeyFile;
+
+    // Keys the auth tokens are signed with. Tokens carry their own claims,
+    // so a command is checked without any state shared between sessions or
+    // proxies, and every proxy with the same keys honours them.
+    TokenKeyring TokenKeys;
+
+    // Builders for messages the proxy writes itself, recycled on QUIC_STREAM_EVENT_SEND_COMPLETE
+    SendBufferPool SendBuffers;
+
+    enum class Side { Client, Upstream };
+
+    // An accepted client connection and the proxy's own connection to a
+    // server on its behalf, opened once the client authenticates and its
+    // robot_id picks the backend. Each connection is closed on its own
+    // SHUTDOWN_COMPLETE and then shuts the other one down; the session goes
+    // away with the last one.
+    struct Session {
+        QuicProxy* Proxy;
+        uint64_t Id;
+        HQUIC Connections[2];   // indexed by Side; Upstream is null until routed
+        bool Closed[2];
+        std::string Backend;    // name of the backend the session was routed to
+        std::mutex Lock;        // guards the above against closing either connection
+        std::atomic<uint32_t> Refs;     // one per open connection
+        TransportStats UpstreamStats;
+        // Client connection's worker only
+        std::string Robot;      // robot_id the session was routed for
+        VerifiedToken Verified; // the token of the client's last command
+        std::string Issued;     // the token last issued on this connection
+        ReplayWindow<> Commands;    // sequence numbers of forwarded commands
+
+        Session(QuicProxy* proxy, uint64_t id, HQUIC client)
+            : Proxy(proxy), Id(id), Connections{client, nullptr}, Closed{false, false}, Refs(1) {}
+    };
+
+    // Per-stream state; each long-lived stream carries length-prefixed frames.
+    // Every stream is paired with a stream the proxy opens on the other
+    // connection of its session, and verified frames are relayed to it as
+    // received. Received data is read in place, so msquic's buffers are held
+    // (the receive returns QUIC_STATUS_PENDING) until every reference to them,
+    // including relays still being sent, is released.
+    struct StreamContext {
+        QuicProxy* Proxy;
+        Session* Owner;
+        Side From;
+        HQUIC Stream;
+        StreamContext* Peer;
+        FrameDecoder Decoder;
+        std::atomic<uint32_t> ReceiveRefs;
+        uint64_t ReceiveLength;
+        std::atomic<uint32_t> Refs;     // the stream, its peer and relays of its data in flight
+        std::mutex Lock;                // orders sends and receive completions against StreamClose
+        bool Closed;
+
+        StreamContext(QuicProxy* proxy, Session* owner, Side from, HQUIC stream)
+            : Proxy(proxy), Owner(owner), From(from), Stream(stream), Peer(nullptr),
+              ReceiveRefs(0), ReceiveLength(0), Refs(1), Closed(false) {}
+    };
+
+    // A verified message and where it came from; Stream is null for a datagram
+    struct Received {
+        Session* Owner;
+        Side From;
+        StreamContext* Stream;
+        const uint8_t* Data;
+        size_t Length;
+        bool InPlace;   // Data lies in a buffer msquic delivered, not in the decoder's
+    };
+
+    // Messages relayed untouched, completed on SEND_COMPLETE or the final datagram send state
+    RelayPool<StreamContext> Relays;
+
+    std::mutex SessionsLock;
+    std::unordered_set<Session*> Sessions;
+    std::atomic<uint64_t> NextSessionId{0};
+
+    // QUIC settings of both the client-facing and the server-facing side
+    TransportProfile Tuning;
+
+    // Messages that failed FlatBuffers verification
+    std::atomic<uint64_t> RejectedMessages{0};
+
+    // Commands dropped as duplicates or too old to tell from a replay
+    std::atomic<uint64_t> ReplayedCommands{0};
+
+    // Commands rejected for a missing, wrong or expired token, and commands let through
+    std::atomic<uint64_t> UnauthorizedCommands{0};
+    std::atomic<uint64_t> AcceptedCommands{0};
+    std::atomic<uint64_t> IssuedTokens{0};
+
+    // Relayed messages and bytes, relays that had to copy the message, and
+    // relays that could not be sent
+    std::atomic<uint64_t> RelayedMessages{0};
+    std::atomic<uint64_t> RelayedBytes{0};
+    std::atomic<uint64_t> CopiedMessages{0};
+    std::atomic<uint64_t> FailedRelays{0};
+
+    std::unique_ptr<MetricsExporter> Metrics;
+
+    static Side Opposite(Side side) { return side == Side::Client ? Side::Upstream : Side::Client; }
+
+    static QUIC_STATUS QUIC_API ClientCallback(
+        HQUIC Connection,
+        void* Context,
+        QUIC_CONNECTION_EVENT* Event) {
+        auto session = static_cast<Session*>(Context);
+        return session->Proxy->HandleConnectionEvent(session, Side::Client, Event);
+    }
+
+    static QUIC_STATUS QUIC_API ServerCallback(
+        HQUIC Connection,
+        void* Context,
+        QUIC_CONNECTION_EVENT* Event) {
+        auto session = static_cast<Session*>(Context);
+        return session->Proxy->HandleConnectionEvent(session, Side::Upstream, Event);
+    }
+
+    static QUIC_STATUS QUIC_API ProbeCallback(
+        HQUIC Connection,
+        void* Context,
+        QUIC_CONNECTION_EVENT* Event) {
+        auto probe = static_cast<Probe*>(Context);
+        return probe->Proxy->HandleProbeEvent(Connection, probe, Event);
+    }
+
+    static QUIC_STATUS QUIC_API ListenerCallback(
+        HQUIC Listener,
+        void* Context,
+        QUIC_LISTENER_EVENT* Event) {
+        auto proxy = static_cast<QuicProxy*>(Context);
+        return proxy->HandleListenerEvent(Listener, Event);
+    }
+
+    static QUIC_STATUS QUIC_API StreamCallback(
+        HQUIC Stream,
+        void* Context,
+        QUIC_STREAM_EVENT* Event) {
+        auto context = static_cast<StreamContext*>(Context);
+        return context->Proxy->HandleStreamEvent(Stream, context, Event);
+    }
+
+    QUIC_STATUS HandleConnectionEvent(Session* Owner, Side From, QUIC_CONNECTION_EVENT* Event) {
+        switch (Event->Type) {
+            case QUIC_CONNECTION_EVENT_CONNECTED:
+                LOG_INFO("{} connected (session {})", From == Side::Client ? "Client" : "Server", Owner->Id);
+                return QUIC_STATUS_SUCCESS;
+
+            case QUIC_CONNECTION_EVENT_PEER_STREAM_STARTED:
+                return AttachStream(Owner, From, Event->PEER_STREAM_STARTED.Stream);
+
+            case QUIC_CONNECTION_EVENT_DATAGRAM_RECEIVED:
+                // Datagram buffers are only valid during the callback, so a relay copies them
+                HandleMessage(Received{Owner, From, nullptr, Event->DATAGRAM_RECEIVED.Buffer->Buffer,
+                                       Event->DATAGRAM_RECEIVED.Buffer->Length, false});
+                return QUIC_STATUS_SUCCESS;
+
+            case QUIC_CONNECTION_EVENT_DATAGRAM_SEND_STATE_CHANGED:
+                if (QUIC_DATAGRAM_SEND_STATE_IS_FINAL(Event->DATAGRAM_SEND_STATE_CHANGED.State) &&
+                    Relays.owns(Event->DATAGRAM_SEND_STATE_CHANGED.ClientContext)) {
+                    CompleteRelay(static_cast<RelaySend<StreamContext>*>(Event->DATAGRAM_SEND_STATE_CHANGED.ClientContext));
+                }
+                return QUIC_STATUS_SUCCESS;
+
+            case QUIC_CONNECTION_EVENT_SHUTDOWN_COMPLETE:
+                LOG_INFO("{} connection shutdown complete (session {})",
+                         From == Side::Client ? "Client" : "Server", Owner->Id);
+                CloseConnection(Owner, From, true);
+                return QUIC_STATUS_SUCCESS;
+
+            default:
+                return QUIC_STATUS_SUCCESS;
+        }
+    }
+
+    QUIC_STATUS HandleProbeEvent(HQUIC Connection, Probe* Target, QUIC_CONNECTION_EVENT* Event) {
+        switch (Event->Type) {
+            case QUIC_CONNECTION_EVENT_DATAGRAM_STATE_CHANGED:
+                Target->DatagramSendEnabled = Event->DATAGRAM_STATE_CHANGED.SendEnabled;
+                return QUIC_STATUS_SUCCESS;
+
+            case QUIC_CONNECTION_EVENT_DATAGRAM_RECEIVED:
+                HandleProbeReply(Connection, Target, Event->DATAGRAM_RECEIVED.Buffer->Buffer, Event->DATAGRAM_RECEIVED.Buffer->Length);
+                return QUIC_STATUS_SUCCESS;
+
+            case QUIC_CONNECTION_EVENT_DATAGRAM_SEND_STATE_CHANGED:
+                if (QUIC_DATAGRAM_SEND_STATE_IS_FINAL(Event->DATAGRAM_SEND_STATE_CHANGED.State) &&
+                    Event->DATAGRAM_SEND_STATE_CHANGED.ClientContext) {
+                    SendBuffers.release(static_cast<SendBuffer*>(Event->DATAGRAM_SEND_STATE_CHANGED.ClientContext));
+                }
+                return QUIC_STATUS_SUCCESS;
+
+            case QUIC_CONNECTION_EVENT_SHUTDOWN_COMPLETE: {
+                // Losing the probe connection fails the probe in flight; the next round reconnects.
+                // Once Connection is cleared a retired probe may be freed, so only the copy of
+                // its name is used after the lock
+                bool retired;
+                std::string name;
+                {
+                    std::lock_guard<std::mutex> guard(Target->Lock);
+                    MsQuic->ConnectionClose(Connection);
+                    Target->Connection = nullptr;
+                    Target->DatagramSendEnabled = false;
+                    Target->Pending = 0;
+                    retired = Target->Retired;
+                    if (!retired) {
+                        name = Target->Target.name;
+                    }
+                }
+                if (!retired) {
+                    LOG_WARN("Lost probe connection to {}", name);
+                    Health.recordFailure(name);
+                }
+                return QUIC_STATUS_SUCCESS;
+            }
+
+            default:
+                return QUIC_STATUS_SUCCESS;
+        }
+    }
+
+    // Records the round trip and load of an answered probe; replies to older
+    // probes than the one in flight, and anything else the server sends, are ignored
+    void HandleProbeReply(HQUIC Connection, Probe* Target, const uint8_t* Data, size_t Length) {
+        const Teleop::Envelope* envelope = OpenEnvelope(Data, Length);
+        if (!envelope || envelope->payload_type() != Teleop::Payload_HealthCheck) {
+            return;
+        }
+        const Teleop::HealthCheck* reply = envelope->payload_as_HealthCheck();
+        uint32_t sequence = reply->sequence();
+        if (!sequence || !Target->Pending.compare_exchange_strong(sequence, 0, std::memory_order_acq_rel)) {
+            return;
+        }
+        uint64_t nowUs = BackendHealth::clockUs();
+        Health.recordProbe(Target->Target.name, nowUs > reply->sent_us() ? nowUs - reply->sent_us() : 0,
+                           reply->sessions(), reply->session_capacity(), reply->queue_depth());
+        Target->Stats.maybeSample(MsQuic, Connection, Health.options().probeIntervalMs * 1000ull);
+        Health.recordTransportRtt(Target->Target.name, Target->Stats.load().rttUs);
+    }
+
+    QUIC_STATUS HandleListenerEvent(HQUIC Listener, QUIC_LISTENER_EVENT* Event) {
+        switch (Event->Type) {
+            case QUIC_LISTENER_EVENT_NEW_CONNECTION:
+                return HandleNewConnection(Event->NEW_CONNECTION.Connection);
+            default:
+                return QUIC_STATUS_SUCCESS;
+        }
+    }
+
+    QUIC_STATUS HandleNewConnection(HQUIC Connection) {
+        if (QUIC_FAILED(MsQuic->ConnectionSetConfiguration(Connection, ListenerConfig))) {
+            // msquic closes a refused connection itself
+            LOG_ERROR("Failed to set client connection configuration");
+            return QUIC_STATUS_CONNECTION_REFUSED;
+        }
+        Session* session = new Session(this, NextSessionId.fetch_add(1, std::memory_order_relaxed), Connection);
+        {
+            std::lock_guard<std::mutex> guard(SessionsLock);
+            Sessions.insert(session);
+        }
+        MsQuic->SetCallbackHandler(Connection, (void*)ClientCallback, session);
+        return QUIC_STATUS_SUCCESS;
+    }
+
+    // Routes the session by its robot_id and the backends' health, and
+    // connects to the backend chosen. Runs on the client connection's
+    // worker, the only writer of the upstream handle.
+    bool OpenUpstream(Session* Owner, std::string_view RobotId) {
+        std::shared_ptr<const HashRing> ring = Backends.ring();
+        const Backend* backend = Health.select(*ring, RobotId, Routing, BackendHealth::clockUs());
+        if (!backend) {
+            LOG_WARN("No backend for session {}", Owner->Id);
+            return false;
+        }
+        HQUIC upstream = nullptr;
+        if (QUIC_FAILED(MsQuic->ConnectionOpen(Registration, ServerCallback, Owner, &upstream))) {
+            LOG_ERROR("Failed to open server connection");
+            return false;
+        }
+        {
+            std::lock_guard<std::mutex> guard(Owner->Lock);
+            Owner->Connections[static_cast<int>(Side::Upstream)] = upstream;
+            Owner->Backend = backend->name;
+        }
+        Owner->Refs.fetch_add(1, std::memory_order_relaxed);
+        if (QUIC_FAILED(MsQuic->ConnectionStart(upstream, UpstreamConfig, QUIC_ADDRESS_FAMILY_UNSPEC,
+                                               backend->host.c_str(), backend->port))) {
+            // Never started, so no callback refers to it; the client stays unrouted
+            LOG_ERROR("Failed to start server connection to {}", backend->name);
+            {
+                std::lock_guard<std::mutex> guard(Owner->Lock);
+                Owner->Connections[static_cast<int>(Side::Upstream)] = nullptr;
+                Owner->Backend.clear();
+            }
+            MsQuic->ConnectionClose(upstream);
+            Owner->Refs.fetch_sub(1, std::memory_order_relaxed);
+            return false;
+        }
+        Owner->Robot.assign(RobotId.data(), RobotId.size());
+        LOG_INFO("Session {} routed to {}", Owner->Id, backend->name);
+        return true;
+    }
+
+    // Closes one connection of a session, which takes the other one down too
+    void CloseConnection(Session* Owner, Side From, bool CloseHandle) {
+        {
+            std::lock_guard<std::mutex> guard(Owner->Lock);
+            Owner->Closed[static_cast<int>(From)] = true;
+            if (CloseHandle) {
+                MsQuic->ConnectionClose(Owner->Connections[static_cast<int>(From)]);
+            }
+            Side other = Opposite(From);
+            if (Owner->Connections[static_cast<int>(other)] && !Owner->Closed[static_cast<int>(other)]) {
+                MsQuic->ConnectionShutdown(Owner->Connections[static_cast<int>(other)], QUIC_CONNECTION_SHUTDOWN_FLAG_NONE, 0);
+            }
+        }
+        if (Owner->Refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            {
+                std::lock_guard<std::mutex> guard(SessionsLock);
+                Sessions.erase(Owner);
+            }
+            delete Owner;
+        }
+    }
+
+    // Attaches a decoder to a stream the peer started and pairs it with a
+    // stream on the session's other connection. A client's streams start
+    // before it is routed; they are paired on their first relay instead.
+    QUIC_STATUS AttachStream(Session* Owner, Side From, HQUIC Stream) {
+        StreamContext* context = new StreamContext(this, Owner, From, Stream);
+        MsQuic->SetCallbackHandler(Stream, (void*)StreamCallback, context);
+        if (From == Side::Upstream && !OpenPeer(context)) {
+            MsQuic->StreamShutdown(Stream, QUIC_STREAM_SHUTDOWN_FLAG_ABORT, 0);
+        }
+        return QUIC_STATUS_SUCCESS;
+    }
+
+    // Opens the stream paired with Context. Runs on Context's worker, the
+    // only one that reads or writes Context->Peer before it shuts down.
+    bool OpenPeer(StreamContext* Context) {
+        Session* owner = Context->Owner;
+        Side to = Opposite(Context->From);
+        StreamContext* peer = new StreamContext(this, owner, to, nullptr);
+        bool opened;
+        {
+            std::lock_guard<std::mutex> guard(owner->Lock);
+            HQUIC connection = owner->Connections[static_cast<int>(to)];
+            opened = connection && !owner->Closed[static_cast<int>(to)] &&
+                     QUIC_SUCCEEDED(MsQuic->StreamOpen(connection, QUIC_STREAM_OPEN_FLAG_NONE,
+                                                       StreamCallback, peer, &peer->Stream));
+        }
+        if (!opened) {
+            LOG_WARN("Failed to open relay stream (session {})", owner->Id);
+            delete peer;
+            return false;
+        }
+        // Each holds a reference to the other until its own shutdown completes
+        Context->Peer = peer;
+        peer->Peer = Context;
+        Context->Refs.fetch_add(1, std::memory_order_relaxed);
+        peer->Refs.fetch_add(1, std::memory_order_relaxed);
+        // A failed start is reported through the peer stream's own events
+        MsQuic->StreamStart(peer->Stream, QUIC_STREAM_START_FLAG_NONE);
+        return true;
+    }
+
+    QUIC_STATUS HandleStreamEvent(HQUIC Stream, StreamContext* Context, QUIC_STREAM_EVENT* Event) {
+        switch (Event->Type) {
+            case QUIC_STREAM_EVENT_RECEIVE:
+                // Decode every frame in the received data. Frames contained in one
+                // buffer are verified and relayed in place; only frames that span
+                // buffers are gathered into the decoder's reusable buffer.
+                Context->ReceiveLength = Event->RECEIVE.TotalBufferLength;
+                Context->ReceiveRefs.store(1, std::memory_order_relaxed);
+                for (uint32_t i = 0; i < Event->RECEIVE.BufferCount; ++i) {
+                    const QUIC_BUFFER& buffer = Event->RECEIVE.Buffers[i];
+                    bool ok = Context->Decoder.feed(buffer.Buffer, buffer.Length,
+                        [this, Context, &buffer](const uint8_t* Data, size_t Length) {
+                            bool inPlace = Data >= buffer.Buffer && Data + Length <= buffer.Buffer + buffer.Length;
+                            HandleMessage(Received{Context->Owner, Context->From, Context, Data, Length, inPlace});
+                        });
+                    if (!ok) {
+                        LOG_WARN("Malformed frame, aborting stream");
+                        MsQuic->StreamShutdown(Stream, QUIC_STREAM_SHUTDOWN_FLAG_ABORT, 0);
+                        break;
+                    }
+                }
+                SampleUpstream(Context);
+                ReleaseReceive(Context);
+                return QUIC_STATUS_PENDING;
+
+            case QUIC_STREAM_EVENT_SEND_COMPLETE:
+                // msquic no longer references the message; recycle its relay slot or builder
+                if (Relays.owns(Event->SEND_COMPLETE.ClientContext)) {
+                    CompleteRelay(static_cast<RelaySend<StreamContext>*>(Event->SEND_COMPLETE.ClientContext));
+                } else if (Event->SEND_COMPLETE.ClientContext) {
+                    SendBuffers.release(static_cast<SendBuffer*>(Event->SEND_COMPLETE.ClientContext));
+                }
+                SampleUpstream(Context);
+                break;
+
+            case QUIC_STREAM_EVENT_PEER_SEND_SHUTDOWN:
+                // Peer is done sending; finish the paired stream's direction too
+                ShutdownPeer(Context, QUIC_STREAM_SHUTDOWN_FLAG_GRACEFUL);
+                break;
+
+            case QUIC_STREAM_EVENT_PEER_SEND_ABORTED:
+                ShutdownPeer(Context, QUIC_STREAM_SHUTDOWN_FLAG_ABORT_SEND);
+                break;
+
+            case QUIC_STREAM_EVENT_PEER_RECEIVE_ABORTED:
+                ShutdownPeer(Context, QUIC_STREAM_SHUTDOWN_FLAG_ABORT_RECEIVE);
+                break;
+
+            case QUIC_STREAM_EVENT_SHUTDOWN_COMPLETE: {
+                {
+                    std::lock_guard<std::mutex> guard(Context->Lock);
+                    Context->Closed = true;
+                    MsQuic->StreamClose(Stream);
+                }
+                StreamContext* peer = Context->Peer;
+                if (peer) {
+                    ReleaseStream(peer);
+                }
+                ReleaseStream(Context);
+                break;
+            }
+
+            default:
+                break;
+        }
+
+        return QUIC_STATUS_SUCCESS;
+    }
+
+    void ShutdownPeer(StreamContext* Context, QUIC_STREAM_SHUTDOWN_FLAGS Flags) {
+        StreamContext* peer = Context->Peer;
+        if (!peer) {
+            return;
+        }
+        std::lock_guard<std::mutex> guard(peer->Lock);
+        if (!peer->Closed) {
+            MsQuic->StreamShutdown(peer->Stream, Flags, 0);
+        }
+    }
+
+    // Samples the server connection's statistics on its own worker
+    void SampleUpstream(StreamContext* Context) {
+        if (Metrics && Context->From == Side::Upstream) {
+            Context->Owner->UpstreamStats.maybeSample(
+                MsQuic, Context->Owner->Connections[static_cast<int>(Side::Upstream)], 1000000);
+        }
+    }
+
+    // Keeps the current receive's msquic buffers alive beyond the callback
+    void RetainReceive(StreamContext* Context) {
+        Context->ReceiveRefs.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Drops a reference; the last one hands the data back to msquic
+    void ReleaseReceive(StreamContext* Context) {
+        if (Context->ReceiveRefs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            std::lock_guard<std::mutex> guard(Context->Lock);
+            if (!Context->Closed) {
+                MsQuic->StreamReceiveComplete(Context->Stream, Context->ReceiveLength);
+            }
+        }
+    }
+
+    void ReleaseStream(StreamContext* Context) {
+        if (Context->Refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            delete Context;
+        }
+    }
+
+    // Sends a verified message on to the other side of its session exactly as
+    // it was received: a frame on the paired stream or a datagram on the other
+    // connection. A frame read in place is sent from msquic's receive buffer,
+    // which stays held until the send completes.
+    bool Relay(const Received& Message, QUIC_SEND_FLAGS Flags = QUIC_SEND_FLAG_NONE) {
+        RelaySend<StreamContext>* relay = Relays.acquire();
+        if (!relay) {
+            FailedRelays.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        bool sent = false;
+        if (Message.Stream) {
+            QUIC_BUFFER* frame;
+            if (Message.InPlace) {
+                relay->From = Message.Stream;
+                RetainReceive(Message.Stream);
+                Message.Stream->Refs.fetch_add(1, std::memory_order_relaxed);
+                frame = relay->frame(Message.Data, Message.Length);
+            } else {
+                frame = relay->frameCopy(Message.Data, Message.Length);
+            }
+            if (!Message.Stream->Peer) {
+                OpenPeer(Message.Stream);
+            }
+            StreamContext* target = Message.Stream->Peer;
+            if (target) {
+                std::lock_guard<std::mutex> guard(target->Lock);
+                sent = !target->Closed &&
+                       QUIC_SUCCEEDED(MsQuic->StreamSend(target->Stream, frame, 2, Flags, relay));
+            }
+        } else {
+            QUIC_BUFFER* datagram = relay->copy(Message.Data, Message.Length);
+            int to = static_cast<int>(Opposite(Message.From));
+            std::lock_guard<std::mutex> guard(Message.Owner->Lock);
+            sent = !Message.Owner->Closed[to] &&
+                   QUIC_SUCCEEDED(MsQuic->DatagramSend(Message.Owner->Connections[to], datagram, 1, Flags, relay));
+        }
+
+        if (!sent) {
+            FailedRelays.fetch_add(1, std::memory_order_relaxed);
+            CompleteRelay(relay);
+            return false;
+        }
+        RelayedMessages.fetch_add(1, std::memory_order_relaxed);
+        RelayedBytes.fetch_add(Message.Length, std::memory_order_relaxed);
+        if (!Message.InPlace) {
+            CopiedMessages.fetch_add(1, std::memory_order_relaxed);
+        }
+        return true;
+    }
+
+    // msquic is done with a relay: hand the source's receive back and free the slot
+    void CompleteRelay(RelaySend<StreamContext>* relay) {
+        StreamContext* source = relay->From;
+        Relays.release(relay);
+        if (source) {
+            ReleaseReceive(source);
+            ReleaseStream(source);
+        }
+    }
+
+    using Dispatcher = MessageDispatcher<QuicProxy, const Received&>;
+
+    // Handlers keyed on the Payload union tag
+    static const Dispatcher& GetDispatcher() {
+        static const Dispatcher dispatcher = Dispatcher()
+            .on(Teleop::Payload_ControlCommand,
+                [](QuicProxy& proxy, const Teleop::Envelope* envelope, const Received& message) {
+                    proxy.HandleControlCommand(envelope->payload_as_ControlCommand(), message);
+                })
+            .on(Teleop::Payload_AuthRequest,
+                [](QuicProxy& proxy, const Teleop::Envelope* envelope, const Received& message) {
+                    proxy.HandleAuthRequest(envelope->payload_as_AuthRequest(), message);
+                })
+            .on(Teleop::Payload_SensorData,
+                [](QuicProxy& proxy, const Teleop::Envelope*, const Received& message) {
+                    proxy.Relay(message);
+                })
+            .on(Teleop::Payload_TimeSync,
+                [](QuicProxy& proxy, const Teleop::Envelope*, const Received& message) {
+                    proxy.Relay(message);
+                });
+        return dispatcher;
+    }
+
+    // Verifies a message before any field is read, so malformed input is
+    // rejected without touching out-of-bounds memory, then dispatches on its tag
+    void HandleMessage(const Received& Message) {
+        const Teleop::Envelope* envelope = OpenEnvelope(Message.Data, Message.Length);
+        if (!envelope || !GetDispatcher().dispatch(*this, envelope, Message)) {
+            RejectedMessages.fetch_add(1, std::memory_order_relaxed);
+            LOG_WARN("Rejected message ({} bytes)", Message.Length);
+        }
+    }
+
+    QUIC_STATUS HandleControlCommand(const Teleop::ControlCommand* command, const Received& Message) {
+        // Verify authentication; commands only ever flow from the client to the server
+        if (Message.From != Side::Client || !command->client_id() || !command->auth_token()) {
+            UnauthorizedCommands.fetch_add(1, std::memory_order_relaxed);
+            return QUIC_STATUS_ACCESS_DENIED;
+        }
+
+        // The token is read in place from the message, and only checked in
+        // full when it differs from the last one on this connection
+        Session* owner = Message.Owner;
+        const flatbuffers::String* token = command->auth_token();
+        const flatbuffers::String* clientId = command->client_id();
+        uint64_t nowSec = std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        if (TokenKeys.verify(token->c_str(), token->size(), nowSec, owner->Verified) != TokenKeyring::Result::Valid ||
+            owner->Verified.token.clientId() != std::string_view(clientId->c_str(), clientId->size()) ||
+            (!owner->Robot.empty() && owner->Verified.token.robotId() != owner->Robot)) {
+            UnauthorizedCommands.fetch_add(1, std::memory_order_relaxed);
+            return QUIC_STATUS_ACCESS_DENIED;
+        }
+
+        // Never forward a replayed command; reordered ones are left for the server to judge
+        ReplayWindow<>::Result order = owner->Commands.check(command->sequence_number());
+        if (order == ReplayWindow<>::Result::Duplicate || order == ReplayWindow<>::Result::Stale) {
+            ReplayedCommands.fetch_add(1, std::memory_order_relaxed);
+            return QUIC_STATUS_INVALID_STATE;
+        }
+
+        // A token from any proxy with our keys routes a session that never
+        // authenticated here, as after a reconnect to another proxy
+        if (!owner->Connections[static_cast<int>(Side::Upstream)] &&
+            !OpenUpstream(owner, owner->Verified.token.robotId())) {
+            return QUIC_STATUS_UNREACHABLE;
+        }
+
+        // Forward the command to the server; stops keep the priority the client gave them
+        AcceptedCommands.fetch_add(1, std::memory_order_relaxed);
+        QUIC_SEND_FLAGS flags = QUIC_SEND_FLAG_NONE;
+        if (command->command_type() == Teleop::CommandType_STOP ||
+            command->command_type() == Teleop::CommandType_EMERGENCY_STOP) {
+            flags = Message.Stream ? QUIC_SEND_FLAG_PRIORITY_WORK
+                                   : QUIC_SEND_FLAG_PRIORITY_WORK | QUIC_SEND_FLAG_DGRAM_PRIORITY;
+        }
+        return Relay(Message, flags) ? QUIC_STATUS_SUCCESS : QUIC_STATUS_OUT_OF_MEMORY;
+    }
+
+    // The proxy answers authentication itself; the request is not relayed.
+    // The first one routes the session to the backend owning its robot.
+    QUIC_STATUS HandleAuthRequest(const Teleop::AuthRequest* request, const Received& Message) {
+        if (Message.From != Side::Client || !Message.Stream || !request->client_id() || !request->robot_id()) {
+            return QUIC_STATUS_INVALID_PARAMETER;
+        }
+        if (!Message.Owner->Connections[static_cast<int>(Side::Upstream)] &&
+            !OpenUpstream(Message.Owner, std::string_view(request->robot_id()->c_str(), request->robot_id()->size()))) {
+            return QUIC_STATUS_UNREACHABLE;
+        }
+
+        // Sign a token valid for a day
+        auto expires_at = std::chrono::system_clock::now() + std::chrono::hours(24);
+        std::string auth_token = TokenKeys.sign(
+            std::string_view(request->client_id()->c_str(), request->client_id()->size()),
+            std::string_view(request->robot_id()->c_str(), request->robot_id()->size()),
+            std::chrono::duration_cast<std::chrono::seconds>(expires_at.time_since_epoch()).count());
+        if (auth_token.empty()) {
+            return QUIC_STATUS_INVALID_PARAMETER;
+        }
+        IssuedTokens.fetch_add(1, std::memory_order_relaxed);
+
+        // Authenticating again revokes the token this connection was given
+        // before. Tokens outlive their connection, so a client can reconnect.
+        Session* owner = Message.Owner;
+        if (!owner->Issued.empty()) {
+            TokenKeys.revoke(owner->Issued.data(), owner->Issued.size(),
+                std::chrono::duration_cast<std::chrono::seconds>(
+                    std::chrono::system_clock::now().time_since_epoch()).count());
+        }
+        owner->Issued = auth_token;
+
+        // Send auth response
+        SendBuffer* buffer = SendBuffers.acquire();
+        if (!buffer) {
+            return QUIC_STATUS_OUT_OF_MEMORY;
+        }
+        flatbuffers::FlatBufferBuilder& builder = buffer->Builder;
+        auto response = Teleop::CreateAuthResponse(
+            builder,
+            true,
+            builder.CreateString(auth_token),
+            std::chrono::duration_cast<std::chrono::seconds>(
+                expires_at.time_since_epoch()).count(),
+            builder.CreateString("")
+        );
+        FinishEnvelope(builder, response);
+
+        // Send the response
+        if (QUIC_FAILED(MsQuic->StreamSend(Message.Stream->Stream, buffer->sealFramed(), 2, QUIC_SEND_FLAG_NONE, buffer))) {
+            SendBuffers.release(buffer);
+            return QUIC_STATUS_INTERNAL_ERROR;
+        }
+
+        return QUIC_STATUS_SUCCESS;
+    }
+
+    // Prober thread: a probe round right away and then every probe interval
+    void ProbeLoop() {
+        std::unique_lock<std::mutex> lock(ProberLock);
+        do {
+            lock.unlock();
+            ProbeBackends();
+            lock.lock();
+        } while (!ProberWake.wait_for(lock, std::chrono::milliseconds(Health.options().probeIntervalMs),
+                                      [this]() { return !Probing; }));
+    }
+
+    // Probes every backend on the ring, retires the probes of removed ones
+    // and then ejects latency outliers
+    void ProbeBackends() {
+        uint64_t nowUs = BackendHealth::clockUs();
+        std::shared_ptr<const HashRing> ring = Backends.ring();
+        auto onRing = [&ring](const std::string& name) {
+            for (const Backend& backend : ring->members()) {
+                if (backend.name == name) {
+                    return true;
+                }
+            }
+            return false;
+        };
+        for (auto it = Probes.begin(); it != Probes.end(); ) {
+            if (onRing(it->first)) {
+                ++it;
+                continue;
+            }
+            Health.forget(it->first);
+            {
+                std::lock_guard<std::mutex> guard(it->second->Lock);
+                it->second->Retired = true;
+                if (it->second->Connection) {
+                    MsQuic->ConnectionShutdown(it->second->Connection, QUIC_CONNECTION_SHUTDOWN_FLAG_NONE, 0);
+                }
+            }
+            RetiredProbes.push_back(std::move(it->second));
+            it = Probes.erase(it);
+        }
+        RetiredProbes.erase(std::remove_if(RetiredProbes.begin(), RetiredProbes.end(),
+            [](const std::unique_ptr<Probe>& probe) {
+                std::lock_guard<std::mutex> guard(probe->Lock);
+                return !probe->Connection;
+            }), RetiredProbes.end());
+
+        for (const Backend& backend : ring->members()) {
+            std::unique_ptr<Probe>& probe = Probes[backend.name];
+            if (!probe) {
+                probe.reset(new Probe(this, backend));
+                Health.track(backend.name);
+            }
+            if (!SendProbe(*probe, nowUs)) {
+                Health.recordFailure(backend.name);
+            }
+        }
+        Health.evaluate(nowUs);
+    }
+
+    // Sends the backend its next probe once the last one is answered or has
+    // timed out, connecting first if needed. Returns false for a failed probe:
+    // one that timed out, or a connection that could not be opened or has
+    // not come up within a probe timeout.
+    bool SendProbe(Probe& Target, uint64_t nowUs) {
+        const uint64_t timeoutUs = Health.options().probeTimeoutMs * 1000ull;
+        uint32_t pending = Target.Pending.load(std::memory_order_acquire);
+        if (pending) {
+            if (nowUs - Target.SentUs < timeoutUs) {
+                return true;
+            }
+            // Lost to the reply if the exchange fails; the next round probes again
+            return !Target.Pending.compare_exchange_strong(pending, 0, std::memory_order_acq_rel);
+        }
+
+        std::lock_guard<std::mutex> guard(Target.Lock);
+        if (!Target.Connection) {
+            Target.OpenedUs = nowUs;
+            if (QUIC_FAILED(MsQuic->ConnectionOpen(Registration, ProbeCallback, &Target, &Target.Connection))) {
+                Target.Connection = nullptr;
+                return false;
+            }
+            if (QUIC_FAILED(MsQuic->ConnectionStart(Target.Connection, UpstreamConfig, QUIC_ADDRESS_FAMILY_UNSPEC,
+                                                   Target.Target.host.c_str(), Target.Target.port))) {
+                MsQuic->ConnectionClose(Target.Connection);
+                Target.Connection = nullptr;
+                return false;
+            }
+            return true;
+        }
+        if (!Target.DatagramSendEnabled) {
+            return nowUs - Target.OpenedUs < timeoutUs;
+        }
+
+        SendBuffer* buffer = SendBuffers.acquire();
+        if (!buffer) {
+            return true;
+        }
+        if (++Target.Sequence == 0) {
+            ++Target.Sequence;
+        }
+        Target.SentUs = nowUs;
+        auto probe = Teleop::CreateHealthCheck(buffer->Builder, Target.Sequence, nowUs);
+        FinishEnvelope(buffer->Builder, probe);
+        // Pending before the send, so a fast reply always finds it
+        Target.Pending.store(Target.Sequence, std::memory_order_release);
+        if (QUIC_FAILED(MsQuic->DatagramSend(Target.Connection, buffer->seal(), 1, QUIC_SEND_FLAG_NONE, buffer))) {
+            Target.Pending = 0;
+            SendBuffers.release(buffer);
+            return false;
+        }
+        return true;
+    }
+
+    // Opens a configuration with the shared settings and loads its credential
+    HQUIC OpenConfiguration(const QUIC_BUFFER& alpn, const QUIC_CREDENTIAL_CONFIG& credential, const char* name) {
+        QUIC_SETTINGS Settings = {0};
+        Tuning.apply(Settings);
+
+        // Relay datagrams and streams in both directions
+        Settings.IsSet.DatagramReceiveEnabled = 1;
+        Settings.DatagramReceiveEnabled = 1;
+        Settings.IsSet.PeerBidiStreamCount = 1;
+        Settings.PeerBidiStreamCount = 128;
+
+        HQUIC Configuration = nullptr;
+        if (QUIC_FAILED(MsQuic->ConfigurationOpen(Registration, &alpn, 1, &Settings,
+                                                 sizeof(Settings), nullptr, &Configuration))) {
+            LOG_ERROR("Failed to open {} configuration", name);
+            return nullptr;
+        }
+        if (QUIC_FAILED(MsQuic->ConfigurationLoadCredential(Configuration, &credential))) {
+            LOG_ERROR("Failed to load {} credentials", name);
+            MsQuic->ConfigurationClose(Configuration);
+            return nullptr;
+        }
+        return Configuration;
+    }
+
+public:
+    QuicProxy() : Running(false) {
+        MsQuic = nullptr;
+        Registration = nullptr;
+        Listener = nullptr;
+        ListenerConfig = nullptr;
+        UpstreamConfig = nullptr;
+    }
+
+    // Takes effect on the next Start()
+    void SetTransportProfile(const TransportProfile& profile) { Tuning = profile; }
+    void SetHealthOptions(const HealthOptions& options) { Health.setOptions(options); }
+
+    // Affinity keeps every robot on its own backend while that one is
+    // available; Latency sends each new session to the cheapest backend
+    void SetRoutingPolicy(RoutingPolicy policy) { Routing = policy; }
+
+    std::vector<BackendStatus> GetBackendStatus() const { return Health.statuses(BackendHealth::clockUs()); }
+
+    // Keys for the auth tokens, safe to change while running. Proxies that
+    // share their keys honour each other's tokens. To rotate, add the new key
+    // everywhere, then use it, then retire the old one once its tokens expired.
+    bool AddTokenKey(uint32_t id, const std::vector<uint8_t>& key, bool signing) {
+        return TokenKeys.add(id, key.data(), key.size(), signing);
+    }
+    bool UseTokenKey(uint32_t id) { return TokenKeys.use(id); }
+    bool RetireTokenKey(uint32_t id) { return TokenKeys.retire(id); }
+    // Refuses a token on this proxy until it expires; false if it is not valid
+    bool RevokeToken(const std::string& token) {
+        return TokenKeys.revoke(token.data(), token.size(), std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count());
+    }
+
+    // Adds a server to route new sessions to; sessions already routed stay put
+    bool AddBackend(const Backend& backend) {
+        if (!Backends.add(backend)) {
+            return false;
+        }
+        LOG_INFO("Backend {} added", backend.name);
+        return true;
+    }
+
+    // Removes a server from the ring and disconnects the sessions routed to
+    // it; their clients reconnect and are routed to the remaining backends
+    bool RemoveBackend(const std::string& name) {
+        if (!Backends.remove(name)) {
+            return false;
+        }
+        std::lock_guard<std::mutex> sessions(SessionsLock);
+        for (Session* session : Sessions) {
+            std::lock_guard<std::mutex> guard(session->Lock);
+            int client = static_cast<int>(Side::Client);
+            if (session->Backend == name && !session->Closed[client]) {
+                MsQuic->ConnectionShutdown(session->Connections[client], QUIC_CONNECTION_SHUTDOWN_FLAG_NONE, 0);
+            }
+        }
+        LOG_INFO("Backend {} removed", name);
+        return true;
+    }
+
+    // Certificate the listener presents to clients, loaded by Start()
+    void SetCertificate(const std::string& certificateFile, const std::string& privateKeyFile) {
+        CertificateFile = certificateFile;
+        PrivateKeyFile = privateKeyFile;
+    }
+
+    bool Initialize() {
+        if (QUIC_FAILED(MsQuicOpen2(&MsQuic))) {
+            LOG_ERROR("Failed to open MsQuic");
+            return false;
+        }
+
+        QUIC_REGISTRATION_CONFIG RegConfig = {
+            "TeleopProxy",
+            QUIC_EXECUTION_PROFILE_LOW_LATENCY
+        };
+
+        if (QUIC_FAILED(MsQuic->RegistrationOpen(&RegConfig, &Registration))) {
+            LOG_ERROR("Failed to open registration");
+            return false;
+        }
+
+        return true;
+    }
+
+    // Listens for clients on ClientPort; every authenticated client gets its
+    // own connection to the backend its robot_id hashes to
+    bool Start(uint16_t ClientPort) {
+        if (!Backends.ring()->size()) {
+            LOG_ERROR("No backends to relay to");
+            return false;
+        }
+        if (!TokenKeys.canSign()) {
+            // Tokens are then good on this proxy, until it restarts
+            std::vector<uint8_t> key(32);
+            if (RAND_bytes(key.data(), static_cast<int>(key.size())) != 1 || !AddTokenKey(0, key, true)) {
+                LOG_ERROR("Failed to generate a token key");
+                return false;
+            }
+        }
+
+        // Setup ALPN buffer
+        const char* alpnStr = "teleop";
+        QUIC_BUFFER alpn;
+        alpn.Buffer = (uint8_t*)alpnStr;
+        alpn.Length = (uint32_t)strlen(alpnStr);
+
+        // Server credential for the listener
+        QUIC_CREDENTIAL_CONFIG ListenerCred;
+        memset(&ListenerCred, 0, sizeof(ListenerCred));
+        QUIC_CERTIFICATE_FILE CertFile;
+        if (!CertificateFile.empty()) {
+            CertFile.CertificateFile = CertificateFile.c_str();
+            CertFile.PrivateKeyFile = PrivateKeyFile.c_str();
+            ListenerCred.Type = QUIC_CREDENTIAL_TYPE_CERTIFICATE_FILE;
+            ListenerCred.CertificateFile = &CertFile;
+        } else {
+            ListenerCred.Type = QUIC_CREDENTIAL_TYPE_NONE;
+            ListenerCred.Flags = QUIC_CREDENTIAL_FLAG_NO_CERTIFICATE_VALIDATION;
+        }
+
+        // Disable certificate validation for testing
+        QUIC_CREDENTIAL_CONFIG UpstreamCred;
+        memset(&UpstreamCred, 0, sizeof(UpstreamCred));
+        UpstreamCred.Type = QUIC_CREDENTIAL_TYPE_NONE;
+        UpstreamCred.Flags = QUIC_CREDENTIAL_FLAG_CLIENT | QUIC_CREDENTIAL_FLAG_NO_CERTIFICATE_VALIDATION;
+
+        // Both stay open for the proxy's lifetime; every new session uses them
+        ListenerConfig = OpenConfiguration(alpn, ListenerCred, "listener");
+        UpstreamConfig = OpenConfiguration(alpn, UpstreamCred, "server");
+        if (!ListenerConfig || !UpstreamConfig) {
+            return false;
+        }
+
+        // Start listening for client connections
+        if (QUIC_FAILED(MsQuic->ListenerOpen(Registration, ListenerCallback, this, &Listener))) {
+            LOG_ERROR("Failed to open client listener");
+            return false;
+        }
+        QUIC_ADDR address = {};
+        QuicAddrSetFamily(&address, QUIC_ADDRESS_FAMILY_UNSPEC);
+        QuicAddrSetPort(&address, ClientPort);
+        if (QUIC_FAILED(MsQuic->ListenerStart(Listener, &alpn, 1, &address))) {
+            LOG_ERROR("ListenerStart failed on port {}", ClientPort);
+            return false;
+        }
+
+        LOG_INFO("Relaying port {} to {} backends", ClientPort, Backends.ring()->size());
+        Running = true;
+        Probing = true;
+        Prober = std::thread(&QuicProxy::ProbeLoop, this);
+        return true;
+    }
+
+    // Serves Prometheus metrics on a loopback port and/or a Unix socket
+    bool StartMetrics(uint16_t port, const std::string& socketPath) {
+        Metrics.reset(new MetricsExporter([this](MetricsWriter& writer) { CollectMetrics(writer); }));
+        if ((port && !Metrics->listenTcp(port)) ||
+            (!socketPath.empty() && !Metrics->listenUnix(socketPath)) ||
+            !Metrics->start()) {
+            LOG_ERROR("Failed to start the metrics endpoint");
+            Metrics.reset();
+            return false;
+        }
+        return true;
+    }
+
+    // Runs on the metrics thread for every scrape
+    void CollectMetrics(MetricsWriter& writer) {
+        writer.counter("teleop_proxy_commands_accepted_total", "Authenticated commands let through",
+                       static_cast<double>(AcceptedCommands.load(std::memory_order_relaxed)));
+        writer.counter("teleop_proxy_commands_unauthorized_total", "Commands with a missing, wrong or expired token",
+                       static_cast<double>(UnauthorizedCommands.load(std::memory_order_relaxed)));
+        writer.counter("teleop_proxy_commands_replayed_total", "Commands dropped as duplicates or stale",
+                       static_cast<double>(ReplayedCommands.load(std::memory_order_relaxed)));
+        writer.counter("teleop_proxy_messages_rejected_total", "Messages that failed verification",
+                       static_cast<double>(RejectedMessages.load(std::memory_order_relaxed)));
+        writer.counter("teleop_proxy_relayed_messages_total", "Messages relayed to the other side",
+                       static_cast<double>(RelayedMessages.load(std::memory_order_relaxed)));
+        writer.counter("teleop_proxy_relayed_bytes_total", "Message bytes relayed to the other side",
+                       static_cast<double>(RelayedBytes.load(std::memory_order_relaxed)));
+        writer.counter("teleop_proxy_relay_copies_total", "Relayed messages that had to be copied (split frames, datagrams)",
+                       static_cast<double>(CopiedMessages.load(std::memory_order_relaxed)));
+        writer.counter("teleop_proxy_relay_failures_total", "Messages that could not be relayed",
+                       static_cast<double>(FailedRelays.load(std::memory_order_relaxed)));
+        writer.counter("teleop_proxy_auth_tokens_issued_total", "Auth tokens signed",
+                       static_cast<double>(IssuedTokens.load(std::memory_order_relaxed)));
+        writer.gauge("teleop_proxy_auth_keys", "Token keys accepted", static_cast<double>(TokenKeys.size()));
+        writer.gauge("teleop_proxy_auth_revoked_tokens", "Unexpired tokens revoked on this proxy",
+                     static_cast<double>(TokenKeys.revoked()));
+        writer.counter("teleop_proxy_send_buffers_exhausted_total", "Sends skipped because every send buffer was in flight",
+                       static_cast<double>(SendBuffers.exhaustedCount()));
+
+        std::vector<std::string> labels;
+        std::vector<TransportSnapshot> snapshots;
+        std::unordered_map<std::string, uint64_t> routed;
+        for (const Backend& backend : Backends.ring()->members()) {
+            routed[backend.name] = 0;
+        }
+        {
+            std::lock_guard<std::mutex> sessions(SessionsLock);
+            writer.gauge("teleop_proxy_sessions", "Client connections being relayed", static_cast<double>(Sessions.size()));
+            for (Session* session : Sessions) {
+                std::lock_guard<std::mutex> guard(session->Lock);
+                if (session->Connections[static_cast<int>(Side::Upstream)]) {
+                    ++routed[session->Backend];
+                    labels.push_back("session=\"" + std::to_string(session->Id) + "\",backend=\"" + session->Backend + "\"");
+                    snapshots.push_back(session->UpstreamStats.load());
+                }
+            }
+        }
+        writer.family("teleop_proxy_backend_sessions", "gauge", "Sessions routed to each backend");
+        for (const auto& backend : routed) {
+            writer.sample("teleop_proxy_backend_sessions", static_cast<double>(backend.second),
+                          "backend=\"" + backend.first + "\"");
+        }
+        WriteTransportMetrics(writer, labels, snapshots);
+
+        std::vector<BackendStatus> health = GetBackendStatus();
+        struct Family {
+            const char* name;
+            const char* type;
+            const char* help;
+            double (*value)(const BackendStatus&);
+        };
+        static const Family families[] = {
+            {"teleop_proxy_backend_available", "gauge", "1 if the backend takes new sessions: up, not ejected, not overloaded",
+             [](const BackendStatus& s) { return s.available ? 1.0 : 0.0; }},
+            {"teleop_proxy_backend_up", "gauge", "1 unless the backend failed its last health probes",
+             [](const BackendStatus& s) { return s.up ? 1.0 : 0.0; }},
+            {"teleop_proxy_backend_ejected", "gauge", "1 while the backend is ejected as a latency outlier",
+             [](const BackendStatus& s) { return s.ejected ? 1.0 : 0.0; }},
+            {"teleop_proxy_backend_probe_rtt_seconds", "gauge", "Smoothed round trip of health probes",
+             [](const BackendStatus& s) { return s.probeRttUs / 1e6; }},
+            {"teleop_proxy_backend_transport_rtt_seconds", "gauge", "msquic's smoothed RTT of the probe connection",
+             [](const BackendStatus& s) { return s.transportRttUs / 1e6; }},
+            {"teleop_proxy_backend_error_rate", "gauge", "Smoothed share of failed health probes",
+             [](const BackendStatus& s) { return s.errorRate; }},
+            {"teleop_proxy_backend_queue_depth", "gauge", "Commands waiting on the backend's control thread",
+             [](const BackendStatus& s) { return static_cast<double>(s.queueDepth); }},
+            {"teleop_proxy_backend_cost", "gauge", "Routing cost in microseconds: latency plus load penalties",
+             [](const BackendStatus& s) { return s.cost; }},
+            {"teleop_proxy_backend_probes_total", "counter", "Health probes sent",
+             [](const BackendStatus& s) { return static_cast<double>(s.probes); }},
+            {"teleop_proxy_backend_probe_failures_total", "counter", "Health probes that failed",
+             [](const BackendStatus& s) { return static_cast<double>(s.failedProbes); }},
+            {"teleop_proxy_backend_ejections_total", "counter", "Times the backend was ejected",
+             [](const BackendStatus& s) { return static_cast<double>(s.ejections); }},
+        };
+        for (const Family& family : families) {
+            writer.family(family.name, family.type, family.help);
+            for (const BackendStatus& status : health) {
+                writer.sample(family.name, family.value(status), "backend=\"" + status.name + "\"");
+            }
+        }
+    }
+
+    void Run() {
+        while (Running) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+    }
+
+    ~QuicProxy() {
+        Metrics.reset();
+        if (Prober.joinable()) {
+            {
+                std::lock_guard<std::mutex> guard(ProberLock);
+                Probing = false;
+            }
+            ProberWake.notify_all();
+            Prober.join();
+        }
+        if (Listener) {
+            MsQuic->ListenerClose(Listener);
+        }
+        if (Registration) {
+            // Every session and probe closes its connections on SHUTDOWN_COMPLETE
+            MsQuic->RegistrationShutdown(Registration, QUIC_CONNECTION_SHUTDOWN_FLAG_NONE, 0);
+        }
+        if (ListenerConfig) {
+            MsQuic->ConfigurationClose(ListenerConfig);
+        }
+        if (UpstreamConfig) {
+            MsQuic->ConfigurationClose(UpstreamConfig);
+        }
+        if (Registration) {
+            MsQuic->RegistrationClose(Registration);
+        }
+        if (MsQuic) {
+            MsQuicClose(MsQuic);
+        }
+    }
+};
+
+#endif // PROXY_H
@@ -0,0 +1,174 @@
+#ifndef RATE_LOOP_H
+#define RATE_LOOP_H
+
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#endif
+
+// Power-of-two buckets of wake-up lateness in microseconds: bucket 0 holds
+// [0, 1) us, bucket i holds [2^(i-1), 2^i) us and the last bucket catches the rest.
+class JitterHistogram {
+    static constexpr size_t Buckets = 22;
+    std::array<uint64_t, Buckets> counts{};
+    uint64_t samples{0};
+    int64_t minNs{INT64_MAX};
+    int64_t maxNs{0};
+    int64_t totalNs{0};
+public:
+    void record(int64_t latenessNs) {
+        if (latenessNs < 0) latenessNs = 0;
+        uint64_t us = static_cast<uint64_t>(latenessNs) / 1000;
+        size_t bucket = 0;
+        while (us && bucket < Buckets - 1) {
+            us >>= 1;
+            ++bucket;
+        }
+        ++counts[bucket];
+        ++samples;
+        totalNs += latenessNs;
+        if (latenessNs < minNs) minNs = latenessNs;
+        if (latenessNs > maxNs) maxNs = latenessNs;
+    }
+
+    uint64_t count() const { return samples; }
+    int64_t max() const { return maxNs; }
+    double mean() const { return samples ? static_cast<double>(totalNs) / samples : 0.0; }
+
+    void print(std::ostream& out) const {
+        if (!samples) {
+            out << "  no samples" << std::endl;
+            return;
+        }
+        out << "  samples: " << samples
+            << ", min: " << minNs / 1000.0 << " us"
+            << ", mean: " << mean() / 1000.0 << " us"
+            << ", max: " << maxNs / 1000.0 << " us" << std::endl;
+        for (size_t i = 0; i < Buckets; ++i) {
+            if (!counts[i]) continue;
+            uint64_t lo = i ? (1ull << (i - 1)) : 0;
+            out << "  [" << lo << ", ";
+            if (i == Buckets - 1) {
+                out << "inf";
+            } else {
+                out << (1ull << i);
+            }
+            out << ") us: " << counts[i] << std::endl;
+        }
+    }
+};
+
+struct RateLoopOptions {
+    double rateHz = 10.0;
+    int cpu = -1;          // pin the loop thread to this CPU when >= 0
+    int fifoPriority = 0;  // run under SCHED_FIFO with this priority when > 0
+};
+
+// Fixed-rate loop driven by absolute deadlines on the monotonic clock, so the
+// cost of each iteration does not accumulate as drift. A tick whose body runs
+// past the next deadline is counted as an overrun and the missed deadlines are
+// skipped rather than fired back to back.
+class RateLoop {
+    using Clock = std::chrono::steady_clock;
+
+    RateLoopOptions options;
+    std::chrono::nanoseconds period;
+    Clock::time_point deadline;
+    JitterHistogram lateness;
+    uint64_t overruns{0};
+    uint64_t missedTicks{0};
+
+    static void sleepUntil(Clock::time_point when) {
+#ifdef __linux__
+        // steady_clock is CLOCK_MONOTONIC on Linux
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(when.time_since_epoch()).count();
+        timespec ts;
+        ts.tv_sec = static_cast<time_t>(ns / 1000000000);
+        ts.tv_nsec = static_cast<long>(ns % 1000000000);
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {
+        }
+#else
+        std::this_thread::sleep_until(when);
+#endif
+    }
+
+public:
+    explicit RateLoop(const RateLoopOptions& opts)
+        : options(opts),
+          period(std::chrono::nanoseconds(static_cast<int64_t>(1e9 / opts.rateHz))) {}
+
+    // Applies CPU pinning and real-time scheduling to the calling thread.
+    // Failures (e.g. missing CAP_SYS_NICE) are reported but not fatal.
+    bool configureThread() {
+        bool ok = true;
+#ifdef __linux__
+        if (options.cpu >= 0) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(options.cpu, &set);
+            int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+            if (err) {
+                std::cerr << "Failed to pin control loop to CPU " << options.cpu << ": " << strerror(err) << std::endl;
+                ok = false;
+            }
+        }
+        if (options.fifoPriority > 0) {
+            sched_param param{};
+            param.sched_priority = options.fifoPriority;
+            int err = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+            if (err) {
+                std::cerr << "Failed to enable SCHED_FIFO: " << strerror(err) << std::endl;
+                ok = false;
+            }
+        }
+#else
+        if (options.cpu >= 0 || options.fifoPriority > 0) {
+            std::cerr << "CPU pinning and SCHED_FIFO are only supported on Linux" << std::endl;
+            ok = false;
+        }
+#endif
+        return ok;
+    }
+
+    // Sets the first deadline one period from now
+    void start() {
+        deadline = Clock::now() + period;
+    }
+
+    // Sleeps until the next deadline and records how late the wake-up was.
+    // If the caller is already past the deadline the tick is an overrun.
+    void wait() {
+        auto now = Clock::now();
+        if (now > deadline) {
+            ++overruns;
+            auto behind = (now - deadline) / period + 1;
+            missedTicks += behind;
+            deadline += behind * period;
+        }
+        sleepUntil(deadline);
+        lateness.record(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - deadline).count());
+        deadline += period;
+    }
+
+    const RateLoopOptions& getOptions() const { return options; }
+    const JitterHistogram& jitter() const { return lateness; }
+    uint64_t overrunCount() const { return overruns; }
+    uint64_t missedTickCount() const { return missedTicks; }
+
+    void printStats(std::ostream& out) const {
+        out << "Control loop at " << options.rateHz << " Hz: "
+            << overruns << " overruns, " << missedTicks << " missed ticks" << std::endl;
+        out << "Wake-up jitter:" << std::endl;
+        lateness.print(out);
+    }
+};
+
+#endif // RATE_LOOP_H
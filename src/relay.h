@@ -0,0 +1,96 @@
+#ifndef RELAY_H
+#define RELAY_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "msquic.h"
+#include "framing.h"
+
+// One message relayed as received, without decoding and re-encoding it. On a
+// framed stream only the varint prefix is rebuilt; the payload is sent from
+// the receive buffer it arrived in, which the source keeps (its receive stays
+// pending) until msquic reports the send complete. Frames the decoder had to
+// gather from several buffers, and datagrams, whose buffers msquic reclaims
+// when the callback returns, are copied once into Copy, whose capacity is
+// reused.
+template <typename Source>
+struct RelaySend {
+    QUIC_BUFFER Frame[2];
+    uint8_t Prefix[Framing::MaxPrefixLength];
+    std::vector<uint8_t> Copy;
+    Source* From{nullptr};          // set while the payload points into From's receive buffer
+    std::atomic<bool> InUse{false};
+
+    // Prefix and payload for a framed stream, payload in place
+    QUIC_BUFFER* frame(const uint8_t* data, size_t length) {
+        Frame[0].Buffer = Prefix;
+        Frame[0].Length = static_cast<uint32_t>(Framing::EncodePrefix(static_cast<uint32_t>(length), Prefix));
+        Frame[1].Buffer = const_cast<uint8_t*>(data);
+        Frame[1].Length = static_cast<uint32_t>(length);
+        return Frame;
+    }
+
+    // Prefix and a private copy of the payload for a framed stream
+    QUIC_BUFFER* frameCopy(const uint8_t* data, size_t length) {
+        Copy.assign(data, data + length);
+        return frame(Copy.data(), length);
+    }
+
+    // A private copy of the payload alone, for a datagram
+    QUIC_BUFFER* copy(const uint8_t* data, size_t length) {
+        Copy.assign(data, data + length);
+        Frame[1].Buffer = Copy.data();
+        Frame[1].Length = static_cast<uint32_t>(length);
+        return &Frame[1];
+    }
+};
+
+// Fixed set of relay slots, claimed with a CAS like SendBufferPool. The
+// slots are contiguous, so owns() tells a relay apart from any other send
+// context completing on the same stream or connection.
+template <typename Source>
+class RelayPool {
+    std::unique_ptr<RelaySend<Source>[]> slots;
+    size_t count;
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> exhausted{0};
+public:
+    explicit RelayPool(size_t slotCount = 256, size_t copyCapacity = 1024)
+        : slots(new RelaySend<Source>[slotCount]), count(slotCount) {
+        for (size_t i = 0; i < count; ++i) {
+            slots[i].Copy.reserve(copyCapacity);
+        }
+    }
+
+    RelaySend<Source>* acquire() {
+        size_t start = next.fetch_add(1, std::memory_order_relaxed);
+        for (size_t i = 0; i < count; ++i) {
+            RelaySend<Source>* slot = &slots[(start + i) % count];
+            bool expected = false;
+            if (slot->InUse.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+                slot->From = nullptr;
+                return slot;
+            }
+        }
+        exhausted.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    void release(RelaySend<Source>* slot) {
+        slot->InUse.store(false, std::memory_order_release);
+    }
+
+    bool owns(const void* context) const {
+        std::less<const void*> before;
+        return !before(context, &slots[0]) && before(context, &slots[0] + count);
+    }
+
+    size_t capacity() const { return count; }
+    size_t exhaustedCount() const { return exhausted.load(std::memory_order_relaxed); }
+};
+
+#endif // RELAY_H
@@ -0,0 +1,91 @@
+#ifndef REPLAY_WINDOW_H
+#define REPLAY_WINDOW_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Sliding-window anti-replay check over 32-bit sequence numbers, as used for
+// IPsec (RFC 4303, with the block-ring bitmap of RFC 6479). The window
+// remembers which of the last Size sequence numbers below the highest one
+// have been seen, so every check is O(1): a bit test, or when the window
+// advances, clearing at most Words bitmap words. Serial number arithmetic
+// keeps this correct when the counter wraps.
+//
+// Besides the verdict it counts what the stream of sequence numbers looked
+// like: gaps (numbers skipped when the window advanced), reordered arrivals
+// that filled such a gap, duplicates and stale numbers that fell behind the
+// window. gaps - reordered is the number of messages still missing.
+//
+// Not thread-safe: msquic delivers all events of a connection on one worker,
+// so a per-connection window is only touched from that thread.
+template <size_t Words = 4>
+class ReplayWindow {
+    static_assert(Words >= 2 && (Words & (Words - 1)) == 0, "Words must be a power of two");
+    static constexpr uint32_t BlockMask = (1u << 26) - 1;  // block number of a 32-bit sequence
+
+    uint64_t bitmap[Words] = {};
+    uint32_t highest{0};
+    bool started{false};
+    uint64_t gaps{0};
+    uint64_t reordered{0};
+    uint64_t duplicates{0};
+    uint64_t stale{0};
+
+    uint64_t& word(uint32_t sequence) { return bitmap[(sequence >> 6) & (Words - 1)]; }
+    static uint64_t bit(uint32_t sequence) { return 1ull << (sequence & 63); }
+
+public:
+    // Sequence numbers guaranteed to be tracked below the highest one; the
+    // word holding the highest is shared, so one word's worth is given up
+    static constexpr uint32_t Size = (Words - 1) * 64;
+
+    enum class Result {
+        New,         // newest so far; the window moved forward
+        Reordered,   // first arrival, but older than the newest
+        Duplicate,   // seen before
+        Stale        // too old to tell; treat as a replay
+    };
+
+    Result check(uint32_t sequence) {
+        if (!started) {
+            started = true;
+            highest = sequence;
+            word(sequence) |= bit(sequence);
+            return Result::New;
+        }
+        int32_t ahead = static_cast<int32_t>(sequence - highest);
+        if (ahead > 0) {
+            uint32_t blocks = ((sequence >> 6) - (highest >> 6)) & BlockMask;
+            if (blocks > Words) {
+                blocks = Words;
+            }
+            for (uint32_t i = 1; i <= blocks; ++i) {
+                bitmap[((highest >> 6) + i) & (Words - 1)] = 0;
+            }
+            gaps += static_cast<uint32_t>(ahead) - 1;
+            highest = sequence;
+            word(sequence) |= bit(sequence);
+            return Result::New;
+        }
+        if (static_cast<uint32_t>(-static_cast<int64_t>(ahead)) > Size) {
+            ++stale;
+            return Result::Stale;
+        }
+        uint64_t& w = word(sequence);
+        if (w & bit(sequence)) {
+            ++duplicates;
+            return Result::Duplicate;
+        }
+        w |= bit(sequence);
+        ++reordered;
+        return Result::Reordered;
+    }
+
+    uint32_t highestSequence() const { return highest; }
+    uint64_t gapCount() const { return gaps; }
+    uint64_t reorderedCount() const { return reordered; }
+    uint64_t duplicateCount() const { return duplicates; }
+    uint64_t staleCount() const { return stale; }
+};
+
+#endif // REPLAY_WINDOW_H
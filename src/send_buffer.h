@@ -0,0 +1,84 @@
+#ifndef SEND_BUFFER_H
+#define SEND_BUFFER_H
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include "msquic.h"
+#include "flatbuffers/flatbuffers.h"
+#include "framing.h"
+
+// A reusable FlatBuffer builder whose finished bytes are handed to msquic
+// as-is. The buffer stays checked out of its pool until msquic reports the
+// send complete, so the builder memory must not be touched before release().
+struct SendBuffer {
+    QUIC_BUFFER Quic;
+    flatbuffers::FlatBufferBuilder Builder;
+    std::atomic<bool> InUse;
+
+    // Varint length prefix and message, sent together on framed streams
+    QUIC_BUFFER Frame[2];
+    uint8_t Prefix[Framing::MaxPrefixLength];
+
+    explicit SendBuffer(size_t initialSize) : Quic{0, nullptr}, Builder(initialSize), InUse(false) {}
+
+    // Points the QUIC_BUFFER at the finished message
+    QUIC_BUFFER* seal() {
+        Quic.Buffer = Builder.GetBufferPointer();
+        Quic.Length = Builder.GetSize();
+        return &Quic;
+    }
+
+    // Prepares the two-buffer frame (prefix, message) for a framed stream
+    QUIC_BUFFER* sealFramed() {
+        seal();
+        Frame[0].Buffer = Prefix;
+        Frame[0].Length = static_cast<uint32_t>(Framing::EncodePrefix(Quic.Length, Prefix));
+        Frame[1] = Quic;
+        return Frame;
+    }
+};
+
+// Fixed set of pre-sized send buffers. Builder::Clear() keeps the underlying
+// allocation, so once every slot has grown to the largest message it carries
+// the steady-state send path performs no heap allocations. Slots are claimed
+// with a CAS, which lets msquic worker threads release buffers while the
+// sending thread acquires them.
+class SendBufferPool {
+    std::vector<std::unique_ptr<SendBuffer>> slots;
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> exhausted{0};
+public:
+    explicit SendBufferPool(size_t count = 64, size_t initialSize = 1024) {
+        slots.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            slots.emplace_back(new SendBuffer(initialSize));
+            // Force the builder to allocate its initial block up front
+            slots.back()->Builder.CreateString("", 0);
+            slots.back()->Builder.Clear();
+        }
+    }
+
+    SendBuffer* acquire() {
+        size_t start = next.fetch_add(1, std::memory_order_relaxed);
+        for (size_t i = 0; i < slots.size(); ++i) {
+            SendBuffer* slot = slots[(start + i) % slots.size()].get();
+            bool expected = false;
+            if (slot->InUse.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+                slot->Builder.Clear();
+                return slot;
+            }
+        }
+        exhausted.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    void release(SendBuffer* buffer) {
+        buffer->InUse.store(false, std::memory_order_release);
+    }
+
+    size_t capacity() const { return slots.size(); }
+    size_t exhaustedCount() const { return exhausted.load(std::memory_order_relaxed); }
+};
+
+#endif // SEND_BUFFER_H
@@ -0,0 +1,918 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "msquic.h"
+#include "teleop_generated.h"
+#include "features.h"
+#include "journal.h"
+#include "clock_sync.h"
+#include "send_buffer.h"
+#include "command_queue.h"
+#include "replay_window.h"
+#include "session_registry.h"
+#include "transport_profile.h"
+#include "transport_stats.h"
+#include "metrics.h"
+#include "framing.h"
+#include "envelope.h"
+#include "log.h"
+
+// A local address to listen on. An empty host listens on every address of
+// both families; otherwise it is an IPv4 or IPv6 literal.
+struct ListenAddress {
+    std::string host;
+    uint16_t port;
+};
+
+// Parses "4433", "0.0.0.0:4433", "[::]:4433" or "[::1]:4433"
+inline bool ParseListenAddress(const std::string& text, ListenAddress& address) {
+    std::string host;
+    std::string port = text;
+    size_t colon = text.rfind(':');
+    if (colon != std::string::npos) {
+        host = text.substr(0, colon);
+        port = text.substr(colon + 1);
+        if (host.size() >= 2 && host.front() == '[' && host.back() == ']') {
+            host = host.substr(1, host.size() - 2);
+        } else if (host.find(':') != std::string::npos) {
+            return false;  // IPv6 hosts need brackets
+        }
+    }
+    if (port.empty() || port.size() > 5 || port.find_first_not_of("0123456789") != std::string::npos) {
+        return false;
+    }
+    unsigned long value = std::stoul(port);
+    if (value == 0 || value > 65535) {
+        return false;
+    }
+    address.host = host;
+    address.port = static_cast<uint16_t>(value);
+    return true;
+}
+
+// Where the server listens and how msquic spreads the work over cores. Each
+// connection is owned by one msquic worker thread; with several workers,
+// connections are partitioned across them and processed in parallel.
+struct ServerOptions {
+    std::vector<ListenAddress> listen{{"", 4433}};
+    QUIC_EXECUTION_PROFILE profile = QUIC_EXECUTION_PROFILE_LOW_LATENCY;
+    // Number of msquic workers; 0 keeps msquic's default of one per processor
+    uint32_t workers = 0;
+    // Processors the workers run on; empty means processors 0..workers-1
+    std::vector<uint16_t> cpus;
+    // Queueing delay beyond which a worker counts as overloaded and new
+    // connections are turned away; 0 keeps msquic's default (250 ms)
+    uint32_t maxWorkerQueueDelayUs = 0;
+    // Directory of the command journal; empty disables journaling
+    std::string journalDirectory = ".";
+    // QUIC settings of accepted connections
+    TransportProfile transport;
+    // Prometheus metrics over HTTP on this loopback port and/or Unix socket;
+    // neither is opened by default
+    uint16_t metricsPort = 0;
+    std::string metricsSocket;
+    // How often each connection's transport statistics are sampled
+    uint32_t statsIntervalMs = 1000;
+    // Answer every command with a TimeSync datagram carrying its send time,
+    // so the client can measure round trips; for benchmarks
+    bool echoCommands = false;
+};
+
+// Modern msquic API expects const QUIC_API_TABLE*
+class QuicServer {
+private:
+    const QUIC_API_TABLE* MsQuic;
+    HQUIC Registration;
+    std::vector<HQUIC> Listeners;
+    ServerOptions Options;
+    std::atomic<bool> Running;
+    bool Verbose;
+    std::atomic<uint64_t> CommandsReceived;
+    std::atomic<uint64_t> SensorMessagesReceived;
+    std::atomic<uint64_t> ConnectionsAccepted;
+    std::atomic<uint64_t> DuplicateCommands{0};
+    std::atomic<uint64_t> StaleCommands{0};
+    std::atomic<uint64_t> MalformedMessages{0};
+
+    // Configuration shared by every accepted connection. It is built once in
+    // Start() and replaced atomically on reload; msquic reference-counts
+    // configurations, so existing connections keep the one they were accepted with.
+    struct SharedConfiguration {
+        const QUIC_API_TABLE* MsQuic;
+        HQUIC Handle;
+        ~SharedConfiguration() {
+            if (Handle) {
+                MsQuic->ConfigurationClose(Handle);
+            }
+        }
+    };
+    std::shared_ptr<const SharedConfiguration> ActiveConfiguration;
+
+    // TLS certificate; when empty, no credential is loaded (testing only)
+    std::string CertificateFile;
+    std::string PrivateKeyFile;
+
+    // New feature helpers
+    CommandJournal Journal;
+    MacroRecorder Recorder;
+    LatencyStats Latency;
+
+    // Latency of the last full interval, published by Run() for the metrics thread
+    std::mutex IntervalLatencyLock;
+    LatencySnapshot IntervalLatency;
+
+    // Serves metrics from its own thread; see CollectMetrics()
+    std::unique_ptr<MetricsExporter> Metrics;
+
+    // Send to apply time of STOP and EMERGENCY_STOP, measured on the control thread
+    LatencyStats StopLatency;
+
+    // Handoff from msquic workers to the control thread in Run()
+    CommandQueue ControlQueue;
+
+    // Stops a connection's robot when its commands stop arriving; one timer
+    // per mailbox, owned by the control thread
+    DeadmanWatchdog Watchdog{ControlQueue.mailboxCount()};
+    std::atomic<uint64_t> WatchdogStops{0};
+
+    // Connections that only answer health probes, left out of the load we report
+    std::atomic<uint32_t> ProbeConnections{0};
+
+    // Clock sync requests; a buffer returns to the pool once msquic is done with it
+    SendBufferPool SendBuffers;
+
+    // Per-connection session, handed to msquic as the connection context
+    struct ConnectionContext {
+        QuicServer* Server;
+        HQUIC Connection;
+        int32_t Mailbox{-1};         // slot in ControlQueue, taken on the first command
+        bool Probe{false};           // health probes only, and no command yet
+        std::string ClientId;        // set through Sessions.bindClient()
+        std::string RobotId;         // set through Sessions.bindRobot()
+        ReplayWindow<> Sequence;     // command sequence numbers seen so far
+        LatencyStats Latency;
+        TransportStats Transport;    // sampled on the connection's worker
+        ClockSync Clock;             // client clock relative to ours
+        uint64_t LastClockSyncUs{0};
+        bool DatagramSendEnabled{false};
+
+        ConnectionContext(QuicServer* server, HQUIC connection)
+            : Server(server), Connection(connection) {}
+    };
+
+    // Every live session, allocated from a fixed pool and findable by
+    // connection, client id or robot id
+    SessionRegistry<ConnectionContext> Sessions{ControlQueue.mailboxCount()};
+
+    // Per-stream decoder; a command stream carries a sequence of length-prefixed frames
+    struct StreamContext {
+        ConnectionContext* Connection;
+        FrameDecoder Decoder;
+    };
+
+    // Listener callback function
+    static QUIC_STATUS QUIC_API ListenerCallback(
+        HQUIC Listener,
+        void* Context,
+        QUIC_LISTENER_EVENT* Event) {
+        auto server = static_cast<QuicServer*>(Context);
+        return server->HandleListenerEvent(Listener, Event);
+    }
+
+    // Connection callback function
+    static QUIC_STATUS QUIC_API ServerCallback(
+        HQUIC Connection,
+        void* Context,
+        QUIC_CONNECTION_EVENT* Event) {
+        auto context = static_cast<ConnectionContext*>(Context);
+        return context->Server->HandleConnectionEvent(Connection, context, Event);
+    }
+
+    // Stream callback function
+    static QUIC_STATUS QUIC_API StreamCallback(
+        HQUIC Stream,
+        void* Context,
+        QUIC_STREAM_EVENT* Event) {
+        auto context = static_cast<StreamContext*>(Context);
+        return context->Connection->Server->HandleStreamEvent(Stream, context, Event);
+    }
+
+    QUIC_STATUS HandleStreamEvent(HQUIC Stream, StreamContext* Context, QUIC_STREAM_EVENT* Event) {
+        switch (Event->Type) {
+            case QUIC_STREAM_EVENT_RECEIVE:
+                for (uint32_t i = 0; i < Event->RECEIVE.BufferCount; ++i) {
+                    const QUIC_BUFFER& buffer = Event->RECEIVE.Buffers[i];
+                    bool ok = Context->Decoder.feed(buffer.Buffer, buffer.Length,
+                        [this, Context](const uint8_t* Data, size_t Length) {
+                            HandleMessage(Context->Connection, Data, Length);
+                        });
+                    if (!ok) {
+                        LOG_WARN("Malformed frame on command stream, aborting it");
+                        MsQuic->StreamShutdown(Stream, QUIC_STREAM_SHUTDOWN_FLAG_ABORT, 0);
+                        break;
+                    }
+                }
+                return QUIC_STATUS_SUCCESS;
+
+            case QUIC_STREAM_EVENT_PEER_SEND_SHUTDOWN:
+                if (!Context->Decoder.idle()) {
+                    LOG_WARN("Command stream ended inside a frame");
+                }
+                return QUIC_STATUS_SUCCESS;
+
+            case QUIC_STREAM_EVENT_SHUTDOWN_COMPLETE:
+                MsQuic->StreamClose(Stream);
+                delete Context;
+                return QUIC_STATUS_SUCCESS;
+
+            default:
+                return QUIC_STATUS_SUCCESS;
+        }
+    }
+
+    using Dispatcher = MessageDispatcher<QuicServer, ConnectionContext*>;
+
+    // Payload types the server accepts from clients
+    static const Dispatcher& GetDispatcher() {
+        static const Dispatcher dispatcher = Dispatcher()
+            .on(Teleop::Payload_ControlCommand,
+                [](QuicServer& server, const Teleop::Envelope* envelope, ConnectionContext* context) {
+                    server.HandleControlCommand(context, envelope->payload_as_ControlCommand());
+                })
+            .on(Teleop::Payload_SensorData,
+                [](QuicServer& server, const Teleop::Envelope* envelope, ConnectionContext* context) {
+                    server.HandleSensorData(context, envelope->payload_as_SensorData());
+                })
+            .on(Teleop::Payload_TimeSync,
+                [](QuicServer& server, const Teleop::Envelope* envelope, ConnectionContext* context) {
+                    server.HandleTimeSync(context, envelope->payload_as_TimeSync());
+                })
+            .on(Teleop::Payload_HealthCheck,
+                [](QuicServer& server, const Teleop::Envelope* envelope, ConnectionContext* context) {
+                    server.HandleHealthCheck(context, envelope->payload_as_HealthCheck());
+                });
+        return dispatcher;
+    }
+
+    // Verifies an envelope and routes it on its payload tag
+    void HandleMessage(ConnectionContext* Context, const uint8_t* Data, size_t Length) {
+        if (Metrics) {
+            Context->Transport.maybeSample(MsQuic, Context->Connection, Options.statsIntervalMs * 1000ull);
+        }
+        const Teleop::Envelope* envelope = OpenEnvelope(Data, Length);
+        if (!envelope) {
+            MalformedMessages.fetch_add(1, std::memory_order_relaxed);
+            LOG_WARN("Dropping malformed message ({} bytes)", Length);
+            return;
+        }
+        // Journal every verified command as received, including ones later dropped as stale
+        if (envelope->payload_type() == Teleop::Payload_ControlCommand && !Options.journalDirectory.empty()) {
+            Journal.append(Data, Length);
+        }
+        if (!GetDispatcher().dispatch(*this, envelope, Context)) {
+            LOG_WARN("Dropping unexpected {} message", Teleop::EnumNamePayload(envelope->payload_type()));
+        }
+    }
+
+    // Hands a command to the control thread unless it is a replay or a newer
+    // one was already received. STOP and EMERGENCY_STOP are passed on even
+    // when they arrive late, but only once (the client may send each twice).
+    void HandleControlCommand(ConnectionContext* Context, const Teleop::ControlCommand* command) {
+        uint64_t receivedUs = SystemTimeUs();
+        CommandsReceived.fetch_add(1, std::memory_order_relaxed);
+        if (auto clientId = command->client_id()) {
+            std::string_view id(clientId->c_str(), clientId->size());
+            if (id != Context->ClientId) {
+                Sessions.bindClient(Context, id);
+            }
+        }
+        ControlSetpoint setpoint = ControlSetpoint::from(command);
+        ReplayWindow<>::Result order = Context->Sequence.check(setpoint.sequence);
+        if (order == ReplayWindow<>::Result::Duplicate) {
+            DuplicateCommands.fetch_add(1, std::memory_order_relaxed);
+            LOG_DEBUG("Dropping duplicate {} (sequence {})", Teleop::EnumNameCommandType(setpoint.type), setpoint.sequence);
+            return;
+        }
+        RequestClockSync(Context, receivedUs);
+        if (Options.echoCommands) {
+            SendCommandEcho(Context, command->timestamp_us(), receivedUs);
+        }
+
+        // One-way latency in our timebase once the client's clock offset is known
+        uint64_t sentUs = command->timestamp_us() ? command->timestamp_us() : command->timestamp() * 1000;
+        if (Context->Clock.synced()) {
+            sentUs = Context->Clock.toLocal(sentUs, receivedUs);
+        }
+        Context->Latency.add(sentUs, receivedUs);
+        Latency.add(sentUs, receivedUs);
+        if (order != ReplayWindow<>::Result::New && !setpoint.isUrgent()) {
+            StaleCommands.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        setpoint.sentUs = sentUs;
+        setpoint.receivedUs = receivedUs;
+        if (Context->Mailbox < 0 && !OpenMailbox(Context)) {
+            return;
+        }
+        ControlQueue.publish(Context->Mailbox, setpoint);
+    }
+
+    // A connection takes a mailbox with its first command; there is one for
+    // every session slot, so only a misconfigured server runs out
+    bool OpenMailbox(ConnectionContext* Context) {
+        Context->Mailbox = ControlQueue.openMailbox();
+        if (Context->Mailbox < 0) {
+            LOG_WARN("Dropping command: all command mailboxes in use");
+            return false;
+        }
+        if (Context->Probe) {
+            Context->Probe = false;
+            ProbeConnections.fetch_sub(1, std::memory_order_relaxed);
+        }
+        return true;
+    }
+
+    // Telemetry is only counted; it also tells which robot the session is for
+    void HandleSensorData(ConnectionContext* Context, const Teleop::SensorData* data) {
+        SensorMessagesReceived.fetch_add(1, std::memory_order_relaxed);
+        if (auto robotId = data->robot_id()) {
+            std::string_view id(robotId->c_str(), robotId->size());
+            if (id != Context->RobotId) {
+                Sessions.bindRobot(Context, id);
+            }
+        }
+    }
+
+    // Sends the client a clock sync request when one is due: every 100 ms
+    // until the filter is full, then every second. Requests go out as
+    // datagrams, so a lost one is simply a missed sample and never a
+    // retransmission that would inflate the measured delay.
+    void RequestClockSync(ConnectionContext* Context, uint64_t nowUs) {
+        uint64_t interval = Context->Clock.sampleCount() < ClockSync::FilterSize ? 100000 : 1000000;
+        if (!Context->DatagramSendEnabled || nowUs - Context->LastClockSyncUs < interval) {
+            return;
+        }
+        SendBuffer* buffer = SendBuffers.acquire();
+        if (!buffer) {
+            return;
+        }
+        Context->LastClockSyncUs = nowUs;
+        auto request = Teleop::CreateTimeSync(buffer->Builder, SystemTimeUs());
+        FinishEnvelope(buffer->Builder, request);
+        if (QUIC_FAILED(MsQuic->DatagramSend(Context->Connection, buffer->seal(), 1, QUIC_SEND_FLAG_NONE, buffer))) {
+            SendBuffers.release(buffer);
+        }
+    }
+
+    // Returns the command's send time in the client's clock with our receive
+    // and transmit times, like the reply to a clock sync request
+    void SendCommandEcho(ConnectionContext* Context, uint64_t sentUs, uint64_t receivedUs) {
+        if (!Context->DatagramSendEnabled || !sentUs) {
+            return;
+        }
+        SendBuffer* buffer = SendBuffers.acquire();
+        if (!buffer) {
+            return;
+        }
+        auto echo = Teleop::CreateTimeSync(buffer->Builder, sentUs, receivedUs, SystemTimeUs());
+        FinishEnvelope(buffer->Builder, echo);
+        if (QUIC_FAILED(MsQuic->DatagramSend(Context->Connection, buffer->seal(), 1, QUIC_SEND_FLAG_NONE, buffer))) {
+            SendBuffers.release(buffer);
+        }
+    }
+
+    void HandleTimeSync(ConnectionContext* Context, const Teleop::TimeSync* reply) {
+        uint64_t receivedUs = SystemTimeUs();
+        if (!Context->Clock.addSample(reply->origin_us(), reply->receive_us(), reply->transmit_us(), receivedUs)) {
+            LOG_DEBUG("Rejected clock sync sample");
+        }
+    }
+
+    // Answers a proxy's health probe with a datagram carrying our load. A
+    // connection that probes before sending any command is the proxy's
+    // prober, and is not counted as a session.
+    void HandleHealthCheck(ConnectionContext* Context, const Teleop::HealthCheck* probe) {
+        if (Context->Mailbox < 0 && !Context->Probe) {
+            Context->Probe = true;
+            ProbeConnections.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (!Context->DatagramSendEnabled) {
+            return;
+        }
+        size_t sessions = Sessions.size();
+        size_t probes = ProbeConnections.load(std::memory_order_relaxed);
+        SendBuffer* buffer = SendBuffers.acquire();
+        if (!buffer) {
+            return;
+        }
+        auto reply = Teleop::CreateHealthCheck(buffer->Builder, probe->sequence(), probe->sent_us(),
+            static_cast<uint32_t>(sessions > probes ? sessions - probes : 0), static_cast<uint32_t>(Sessions.capacity()),
+            static_cast<uint32_t>(ControlQueue.pendingUrgent() + ControlQueue.pendingSetpoints()));
+        FinishEnvelope(buffer->Builder, reply);
+        if (QUIC_FAILED(MsQuic->DatagramSend(Context->Connection, buffer->seal(), 1, QUIC_SEND_FLAG_NONE, buffer))) {
+            SendBuffers.release(buffer);
+        }
+    }
+
+    QUIC_STATUS HandleConnectionEvent(HQUIC Connection, ConnectionContext* Context, QUIC_CONNECTION_EVENT* Event) {
+        switch (Event->Type) {
+            case QUIC_CONNECTION_EVENT_CONNECTED:
+                ConnectionsAccepted.fetch_add(1, std::memory_order_relaxed);
+                if (!Verbose) {
+                    return QUIC_STATUS_SUCCESS;
+                }
+                LOG_INFO("Client connected (ALPN: {}, session resumed: {})",
+                         LogString((const char*)Event->CONNECTED.NegotiatedAlpn, Event->CONNECTED.NegotiatedAlpnLength),
+                         Event->CONNECTED.SessionResumed ? "yes" : "no");
+                return QUIC_STATUS_SUCCESS;
+                
+            case QUIC_CONNECTION_EVENT_SHUTDOWN_INITIATED_BY_TRANSPORT:
+                LOG_INFO("Transport shutdown with status: {}, error code: {}",
+                         LogHex(Event->SHUTDOWN_INITIATED_BY_TRANSPORT.Status),
+                         LogHex(Event->SHUTDOWN_INITIATED_BY_TRANSPORT.ErrorCode));
+                return QUIC_STATUS_SUCCESS;
+                
+            case QUIC_CONNECTION_EVENT_SHUTDOWN_INITIATED_BY_PEER:
+                LOG_INFO("Peer shutdown with error code: {}", LogHex(Event->SHUTDOWN_INITIATED_BY_PEER.ErrorCode));
+                return QUIC_STATUS_SUCCESS;
+                
+            case QUIC_CONNECTION_EVENT_SHUTDOWN_COMPLETE: {
+                LatencySnapshot latency = Context->Latency.snapshot();
+                LOG_INFO("Connection shutdown complete (latency us p50 {} p99 {} p99.9 {} max {} over {} commands)",
+                         latency.p50, latency.p99, latency.p999, latency.max, latency.count);
+                LOG_INFO("  Command sequence: {} gaps, {} reordered, {} duplicates, {} stale",
+                         Context->Sequence.gapCount(), Context->Sequence.reorderedCount(),
+                         Context->Sequence.duplicateCount(), Context->Sequence.staleCount());
+                if (Context->Clock.synced()) {
+                    LOG_INFO("  Client clock offset {} us (delay {} us), drift {} ppm over {} samples",
+                             Context->Clock.offset(), Context->Clock.delay(), Context->Clock.driftPpm(),
+                             Context->Clock.sampleCount());
+                }
+                if (!Event->SHUTDOWN_COMPLETE.AppCloseInProgress) {
+                    MsQuic->ConnectionClose(Connection);
+                }
+                if (Context->Mailbox >= 0) {
+                    ControlQueue.closeMailbox(Context->Mailbox);
+                }
+                if (Context->Probe) {
+                    ProbeConnections.fetch_sub(1, std::memory_order_relaxed);
+                }
+                Sessions.destroy(Context);
+                return QUIC_STATUS_SUCCESS;
+            }
+                
+            case QUIC_CONNECTION_EVENT_STREAMS_AVAILABLE:
+                LOG_DEBUG("Streams available");
+                return QUIC_STATUS_SUCCESS;
+                
+            case QUIC_CONNECTION_EVENT_PEER_STREAM_STARTED:
+                LOG_DEBUG("Peer stream started");
+                MsQuic->SetCallbackHandler(
+                    Event->PEER_STREAM_STARTED.Stream,
+                    (void*)StreamCallback,
+                    new StreamContext{Context, FrameDecoder()});
+                return QUIC_STATUS_SUCCESS;
+                
+            case QUIC_CONNECTION_EVENT_PEER_NEEDS_STREAMS:
+                LOG_DEBUG("Peer needs streams");
+                return QUIC_STATUS_SUCCESS;
+                
+            case QUIC_CONNECTION_EVENT_DATAGRAM_STATE_CHANGED:
+                LOG_DEBUG("Datagram state changed");
+                Context->DatagramSendEnabled = Event->DATAGRAM_STATE_CHANGED.SendEnabled;
+                return QUIC_STATUS_SUCCESS;
+
+            case QUIC_CONNECTION_EVENT_DATAGRAM_RECEIVED:
+                HandleMessage(Context,
+                                     Event->DATAGRAM_RECEIVED.Buffer->Buffer,
+                                     Event->DATAGRAM_RECEIVED.Buffer->Length);
+                return QUIC_STATUS_SUCCESS;
+
+#ifdef QUIC_API_ENABLE_PREVIEW_FEATURES
+            case QUIC_CONNECTION_EVENT_NETWORK_STATISTICS:
+                Context->Transport.setBytesInFlight(Event->NETWORK_STATISTICS.BytesInFlight);
+                return QUIC_STATUS_SUCCESS;
+#endif
+
+            case QUIC_CONNECTION_EVENT_DATAGRAM_SEND_STATE_CHANGED:
+                if (QUIC_DATAGRAM_SEND_STATE_IS_FINAL(Event->DATAGRAM_SEND_STATE_CHANGED.State)) {
+                    SendBuffers.release(static_cast<SendBuffer*>(Event->DATAGRAM_SEND_STATE_CHANGED.ClientContext));
+                }
+                return QUIC_STATUS_SUCCESS;
+                
+            case QUIC_CONNECTION_EVENT_RESUMED:
+                LOG_INFO("Connection resumed");
+                return QUIC_STATUS_SUCCESS;
+                
+            default:
+                LOG_DEBUG("Unknown event: {}", Event->Type);
+                return QUIC_STATUS_SUCCESS;
+        }
+    }
+
+public:
+    explicit QuicServer(const ServerOptions& options = ServerOptions())
+        : MsQuic(nullptr), Registration(nullptr), Options(options), Running(false),
+          Verbose(true), CommandsReceived(0), SensorMessagesReceived(0), ConnectionsAccepted(0) {}
+
+    void Stop() { Running = false; }
+    // Per-command console output; benchmarks turn it off
+    void SetVerbose(bool verbose) { Verbose = verbose; }
+    uint64_t GetCommandsReceived() const { return CommandsReceived.load(std::memory_order_relaxed); }
+    uint64_t GetConnectionsAccepted() const { return ConnectionsAccepted.load(std::memory_order_relaxed); }
+
+    // Certificate used by the next configuration built by Start() or ReloadConfiguration()
+    void SetCertificate(const std::string& certificateFile, const std::string& privateKeyFile) {
+        CertificateFile = certificateFile;
+        PrivateKeyFile = privateKeyFile;
+    }
+    MacroRecorder& GetRecorder() { return Recorder; }
+    // Latency of commands from every connection since the last interval snapshot
+    LatencyStats& GetLatency() { return Latency; }
+    LatencyStats& GetStopLatency() { return StopLatency; }
+    // Dead-man timeout per connection (default 250 ms, 0 disables); set before Run()
+    void SetWatchdogTimeout(std::chrono::milliseconds timeout) { Watchdog.setTimeout(timeout); }
+    size_t GetSessionCount() const { return Sessions.size(); }
+    // True if a connected session has reported this robot id
+    bool IsRobotConnected(std::string_view robotId) const {
+        return Sessions.visitRobot(robotId, [](const ConnectionContext&) {});
+    }
+    uint64_t GetWatchdogStops() const { return WatchdogStops.load(std::memory_order_relaxed); }
+    uint64_t GetSensorMessagesReceived() const { return SensorMessagesReceived.load(std::memory_order_relaxed); }
+
+    bool Initialize() {
+        if (QUIC_FAILED(MsQuicOpen2(&MsQuic))) {
+            LOG_ERROR("Failed to open MsQuic");
+            return false;
+        }
+        // The worker layout is process-wide and only takes effect before the
+        // first registration is opened
+        if (Options.workers || !Options.cpus.empty()) {
+            SetExecutionConfig();
+        }
+        QUIC_REGISTRATION_CONFIG RegConfig = {
+            "TeleopServer",
+            Options.profile
+        };
+        if (QUIC_FAILED(MsQuic->RegistrationOpen(&RegConfig, &Registration))) {
+            LOG_ERROR("Failed to open registration");
+            return false;
+        }
+                
+        return true;
+    }
+
+    void SetExecutionConfig() {
+#ifdef QUIC_API_ENABLE_PREVIEW_FEATURES
+        std::vector<uint16_t> cpus = Options.cpus;
+        for (uint16_t cpu = 0; cpus.empty() && cpu < Options.workers; ++cpu) {
+            cpus.push_back(cpu);
+        }
+        if (Options.workers && Options.workers < cpus.size()) {
+            cpus.resize(Options.workers);
+        }
+        std::vector<uint8_t> buffer(QUIC_GLOBAL_EXECUTION_CONFIG_MIN_SIZE + cpus.size() * sizeof(uint16_t));
+        auto config = reinterpret_cast<QUIC_GLOBAL_EXECUTION_CONFIG*>(buffer.data());
+        config->ProcessorCount = static_cast<uint32_t>(cpus.size());
+        memcpy(config->ProcessorList, cpus.data(), cpus.size() * sizeof(uint16_t));
+        if (QUIC_FAILED(MsQuic->SetParam(nullptr, QUIC_PARAM_GLOBAL_EXECUTION_CONFIG,
+                                         static_cast<uint32_t>(buffer.size()), buffer.data()))) {
+            LOG_WARN("Failed to set the execution config; msquic keeps its default workers");
+            return;
+        }
+        LOG_INFO("{} msquic workers, first on processor {}", cpus.size(), cpus.front());
+#else
+        LOG_WARN("Worker count and processor affinity need msquic preview features; using defaults");
+#endif
+    }
+
+    // Builds the settings and credentials every accepted connection uses
+    std::shared_ptr<const SharedConfiguration> BuildConfiguration() {
+        const char* alpnStr = "teleop";
+        QUIC_BUFFER alpn;
+        alpn.Buffer = (uint8_t*)alpnStr;
+        alpn.Length = (uint32_t)strlen(alpnStr);
+        
+        QUIC_SETTINGS Settings = {0};
+        Options.transport.apply(Settings);
+
+        // Accept command datagrams from clients
+        Settings.IsSet.DatagramReceiveEnabled = 1;
+        Settings.DatagramReceiveEnabled = 1;
+
+        // Let clients open command streams
+        Settings.IsSet.PeerBidiStreamCount = 1;
+        Settings.PeerBidiStreamCount = 128;
+
+#ifdef QUIC_API_ENABLE_PREVIEW_FEATURES
+        // Bytes in flight for the metrics come with this event
+        if (Options.metricsPort || !Options.metricsSocket.empty()) {
+            Settings.IsSet.NetStatsEventEnabled = 1;
+            Settings.NetStatsEventEnabled = 1;
+        }
+#endif
+
+        if (Options.maxWorkerQueueDelayUs) {
+            Settings.IsSet.MaxWorkerQueueDelayUs = 1;
+            Settings.MaxWorkerQueueDelayUs = Options.maxWorkerQueueDelayUs;
+        }
+        
+        LOG_INFO("Creating configuration with ALPN: {}, transport profile {}", alpnStr, Options.transport.name);
+        HQUIC Configuration = nullptr;
+        if (QUIC_FAILED(MsQuic->ConfigurationOpen(Registration, &alpn, 1, 
+                                                 &Settings, sizeof(Settings), 
+                                                 nullptr, &Configuration))) {
+            LOG_ERROR("Failed to open configuration");
+            return nullptr;
+        }
+        std::shared_ptr<const SharedConfiguration> shared(new SharedConfiguration{MsQuic, Configuration});
+        
+        QUIC_CREDENTIAL_CONFIG CredConfig;
+        memset(&CredConfig, 0, sizeof(CredConfig));
+        QUIC_CERTIFICATE_FILE CertFile;
+        if (!CertificateFile.empty()) {
+            CertFile.CertificateFile = CertificateFile.c_str();
+            CertFile.PrivateKeyFile = PrivateKeyFile.c_str();
+            CredConfig.Type = QUIC_CREDENTIAL_TYPE_CERTIFICATE_FILE;
+            CredConfig.CertificateFile = &CertFile;
+        } else {
+            // Use a simple credential setup for testing
+            CredConfig.Type = QUIC_CREDENTIAL_TYPE_NONE;
+            CredConfig.Flags = QUIC_CREDENTIAL_FLAG_NO_CERTIFICATE_VALIDATION;
+        }
+        
+        LOG_INFO("Loading credentials");
+        if (QUIC_FAILED(MsQuic->ConfigurationLoadCredential(Configuration, &CredConfig))) {
+            LOG_ERROR("Failed to load credentials");
+            return nullptr;
+        }
+        return shared;
+    }
+
+    // Builds a new configuration (e.g. after a certificate rotation) and makes
+    // it the one new connections get. Established connections are unaffected.
+    bool ReloadConfiguration() {
+        auto configuration = BuildConfiguration();
+        if (!configuration) {
+            return false;
+        }
+        std::atomic_store(&ActiveConfiguration, configuration);
+        LOG_INFO("Configuration reloaded");
+        return true;
+    }
+
+    bool Start() {
+        ActiveConfiguration = BuildConfiguration();
+        if (!ActiveConfiguration) {
+            return false;
+        }
+
+        // Up before the listeners, so connections only ever see it set
+        if (Options.metricsPort || !Options.metricsSocket.empty()) {
+            Metrics.reset(new MetricsExporter([this](MetricsWriter& writer) { CollectMetrics(writer); }));
+            if ((Options.metricsPort && !Metrics->listenTcp(Options.metricsPort)) ||
+                (!Options.metricsSocket.empty() && !Metrics->listenUnix(Options.metricsSocket)) ||
+                !Metrics->start()) {
+                LOG_ERROR("Failed to start the metrics endpoint");
+                return false;
+            }
+            LOG_INFO("Serving metrics on port {} / socket {}", Options.metricsPort, Options.metricsSocket);
+        }
+
+        // Setup ALPN buffer for negotiation
+        const char* alpnStr = "teleop";
+        QUIC_BUFFER alpn;
+        alpn.Buffer = (uint8_t*)alpnStr;
+        alpn.Length = (uint32_t)strlen(alpnStr);
+
+        // One listener per address; msquic spreads each one's connections over its workers
+        for (const ListenAddress& listen : Options.listen) {
+            QUIC_ADDR address = {};
+            if (listen.host.empty()) {
+                QuicAddrSetFamily(&address, QUIC_ADDRESS_FAMILY_UNSPEC);
+                QuicAddrSetPort(&address, listen.port);
+            } else if (!QuicAddrFromString(listen.host.c_str(), listen.port, &address)) {
+                LOG_ERROR("Invalid listen address {}", listen.host);
+                return false;
+            }
+
+            HQUIC Listener = nullptr;
+            if (QUIC_FAILED(MsQuic->ListenerOpen(Registration, ListenerCallback, this, &Listener))) {
+                LOG_ERROR("Failed to open listener");
+                return false;
+            }
+            Listeners.push_back(Listener);
+
+            LOG_INFO("Starting listener on {}:{} with ALPN: {}",
+                     listen.host.empty() ? "*" : listen.host.c_str(), listen.port, alpnStr);
+            if (QUIC_FAILED(MsQuic->ListenerStart(Listener, &alpn, 1, &address))) {
+                LOG_ERROR("ListenerStart failed on port {}", listen.port);
+                return false;
+            }
+        }
+        
+        if (!Options.journalDirectory.empty() && !Journal.open(Options.journalDirectory, "commands")) {
+            LOG_ERROR("Failed to open command journal");
+        }
+
+        Running = true;
+        LOG_INFO("Server started with {} listeners", Listeners.size());
+        return true;
+    }
+
+    QUIC_STATUS HandleListenerEvent(HQUIC Listener, QUIC_LISTENER_EVENT* Event) {
+        switch (Event->Type) {
+            case QUIC_LISTENER_EVENT_NEW_CONNECTION: {
+                if (Verbose && Event->NEW_CONNECTION.Info) {
+                    const QUIC_NEW_CONNECTION_INFO* info = Event->NEW_CONNECTION.Info;
+                    // Get the address in a platform-compatible way
+                    if (info->RemoteAddress->Ip.sa_family == QUIC_ADDRESS_FAMILY_INET) {
+                        // IPv4
+                        const uint8_t* ip = (const uint8_t*)&info->RemoteAddress->Ipv4.sin_addr.s_addr;
+                        LOG_INFO("New connection received from {}.{}.{}.{}:{}",
+                                 ip[0], ip[1], ip[2], ip[3], ntohs(info->RemoteAddress->Ipv4.sin_port));
+                    } else {
+                        // IPv6 or other
+                        LOG_INFO("New connection received from (IPv6 address)");
+                    }
+                    LOG_INFO("  Server name: {}, negotiated ALPN: {}",
+                             LogString(info->ServerName, info->ServerNameLength),
+                             LogString((const char*)info->NegotiatedAlpn, info->NegotiatedAlpnLength));
+                }
+                
+                // Accept the connection
+                auto context = Sessions.create(this, Event->NEW_CONNECTION.Connection);
+                if (!context) {
+                    LOG_WARN("Refusing connection: session table full");
+                    return QUIC_STATUS_CONNECTION_REFUSED;
+                }
+                MsQuic->SetCallbackHandler(
+                    Event->NEW_CONNECTION.Connection,
+                    (void*)ServerCallback,
+                    context);
+                
+                // Every connection shares the configuration built at Start()
+                auto configuration = std::atomic_load(&ActiveConfiguration);
+                if (!configuration ||
+                    QUIC_FAILED(MsQuic->ConnectionSetConfiguration(
+                        Event->NEW_CONNECTION.Connection, configuration->Handle))) {
+                    LOG_ERROR("Failed to set configuration on connection");
+                    Sessions.destroy(context);
+                    return QUIC_STATUS_INTERNAL_ERROR;
+                }
+                return QUIC_STATUS_SUCCESS;
+            }
+            default:
+                LOG_DEBUG("Unknown listener event: {}", Event->Type);
+                return QUIC_STATUS_SUCCESS;
+        }
+    }
+
+    // Control thread: applies commands handed over by the msquic workers as
+    // soon as they arrive. Once a second it also injects a demo command and
+    // reports the latency of the last interval.
+    void Run() {
+        auto nextDemo = std::chrono::steady_clock::now();
+        while (Running) {
+            uint64_t nowMs = DeadmanWatchdog::clockMs();
+            ControlQueue.drain([this, nowMs](const ControlSetpoint& setpoint) {
+                if (!setpoint.isUrgent()) {
+                    Watchdog.feed(setpoint.mailbox, setpoint.generation, nowMs);
+                }
+                ProcessControlCommand(setpoint);
+            });
+            Watchdog.expire(nowMs, [this](uint32_t mailbox, uint32_t generation) {
+                OnWatchdogExpired(mailbox, generation);
+            });
+
+            auto now = std::chrono::steady_clock::now();
+            if (now >= nextDemo) {
+                ControlSetpoint demo{};
+                demo.type = Teleop::CommandType_MOVE;
+                demo.linearVelocity = 0.5f;
+                demo.sentUs = demo.receivedUs = SystemTimeUs();
+                ProcessControlCommand(demo);
+
+                LatencySnapshot interval = Latency.snapshotAndReset();
+                {
+                    std::lock_guard<std::mutex> lock(IntervalLatencyLock);
+                    IntervalLatency = interval;
+                }
+                if (interval.count) {
+                    LOG_INFO("Latency over the last interval (us): p50 {} p90 {} p99 {} p99.9 {} max {} ({} commands)",
+                             interval.p50, interval.p90, interval.p99, interval.p999, interval.max, interval.count);
+                }
+                nextDemo += std::chrono::seconds(1);
+                continue;
+            }
+            // Wake often enough to stop a silent connection close to its deadline
+            auto timeout = std::min<std::chrono::nanoseconds>(nextDemo - now, std::chrono::milliseconds(100));
+            if (Watchdog.armedCount()) {
+                timeout = std::min<std::chrono::nanoseconds>(timeout, std::chrono::milliseconds(5));
+            }
+            ControlQueue.wait(timeout);
+        }
+    }
+
+    // Runs on the metrics thread for every scrape. Reads only atomics, the
+    // latency histograms and the sessions' sampled transport statistics.
+    void CollectMetrics(MetricsWriter& writer) {
+        writer.counter("teleop_commands_received_total", "Commands received",
+                       static_cast<double>(GetCommandsReceived()));
+        writer.counter("teleop_commands_duplicate_total", "Commands dropped as duplicates",
+                       static_cast<double>(DuplicateCommands.load(std::memory_order_relaxed)));
+        writer.counter("teleop_commands_stale_total", "Setpoints dropped as older than one already received",
+                       static_cast<double>(StaleCommands.load(std::memory_order_relaxed)));
+        writer.counter("teleop_commands_overwritten_total", "Setpoints replaced in the mailbox before the control thread applied them",
+                       static_cast<double>(ControlQueue.overwrittenCount()));
+        writer.counter("teleop_messages_malformed_total", "Messages that failed verification",
+                       static_cast<double>(MalformedMessages.load(std::memory_order_relaxed)));
+        writer.counter("teleop_sensor_messages_received_total", "Sensor messages received",
+                       static_cast<double>(GetSensorMessagesReceived()));
+        writer.counter("teleop_connections_accepted_total", "Connections accepted",
+                       static_cast<double>(GetConnectionsAccepted()));
+        writer.counter("teleop_watchdog_stops_total", "Robots stopped by the dead-man watchdog",
+                       static_cast<double>(GetWatchdogStops()));
+        writer.counter("teleop_send_buffers_exhausted_total", "Sends skipped because every send buffer was in flight",
+                       static_cast<double>(SendBuffers.exhaustedCount()));
+        writer.gauge("teleop_sessions", "Connected sessions", static_cast<double>(Sessions.size()));
+        writer.gauge("teleop_control_queue_urgent", "Stops waiting for the control thread",
+                     static_cast<double>(ControlQueue.pendingUrgent()));
+        writer.gauge("teleop_control_queue_setpoints", "Mailboxes waiting for the control thread",
+                     static_cast<double>(ControlQueue.pendingSetpoints()));
+
+        LatencySnapshot interval;
+        {
+            std::lock_guard<std::mutex> lock(IntervalLatencyLock);
+            interval = IntervalLatency;
+        }
+        writer.summary("teleop_command_latency_seconds", "One-way command latency over the last second", interval);
+        writer.summary("teleop_stop_latency_seconds", "Send to apply time of stops since start", StopLatency.snapshot());
+
+        std::vector<std::string> labels;
+        std::vector<TransportSnapshot> transport;
+        Sessions.forEach([&](const ConnectionContext& session) {
+            labels.push_back("connection=\"" + std::to_string(Sessions.slotOf(&session)) + "\"");
+            transport.push_back(session.Transport.load());
+        });
+        WriteTransportMetrics(writer, labels, transport);
+    }
+
+    // No command from the connection within the watchdog timeout
+    void OnWatchdogExpired(uint32_t mailbox, uint32_t generation) {
+        if (generation != ControlQueue.mailboxGeneration(mailbox)) {
+            return;  // the connection has closed since
+        }
+        WatchdogStops.fetch_add(1, std::memory_order_relaxed);
+        LOG_WARN("No command from connection {} for {} ms, stopping", mailbox, Watchdog.timeout().count());
+        ControlSetpoint stop{};
+        stop.type = Teleop::CommandType_STOP;
+        stop.mailbox = mailbox;
+        stop.generation = generation;
+        ProcessControlCommand(stop);
+    }
+
+    // Runs on the control thread only
+    void ProcessControlCommand(const ControlSetpoint& cmd) {
+        if (cmd.isUrgent() && cmd.sentUs) {
+            StopLatency.add(cmd.sentUs, SystemTimeUs());
+        }
+        Recorder.record(cmd);
+
+        if (!Verbose) {
+            return;
+        }
+        if (cmd.isUrgent()) {
+            LOG_WARN("{} applied (sequence {})", Teleop::EnumNameCommandType(cmd.type), cmd.sequence);
+        }
+        if (Recorder.isRecording()) {
+            LOG_INFO("Recording command (macro size: {})", Recorder.get().size());
+        }
+    }
+
+    ~QuicServer() {
+        Metrics.reset();
+        for (HQUIC Listener : Listeners) {
+            MsQuic->ListenerClose(Listener);
+        }
+        ActiveConfiguration.reset();
+        if (Registration) {
+            MsQuic->RegistrationClose(Registration);
+        }
+        if (MsQuic) {
+            MsQuicClose(MsQuic);
+        }
+        LOG_INFO("Recorded macro length: {}", Recorder.get().size());
+    }
+};
+
+#endif // SERVER_H
@@ -0,0 +1,223 @@
+#ifndef SESSION_REGISTRY_H
+#define SESSION_REGISTRY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include "bounded_queue.h"
+
+// Fixed-capacity pool of objects with stable addresses. The storage for every
+// slot is reserved once, so a session's memory never moves and its address
+// can be handed to msquic as a context pointer. Free slots are kept in a
+// lock-free queue; acquire() and release() may be called from any thread.
+template <typename T>
+class ObjectPool {
+    struct alignas(T) Slot {
+        unsigned char bytes[sizeof(T)];
+    };
+    std::unique_ptr<Slot[]> slots;
+    size_t count;
+    BoundedQueue<uint32_t> free;
+public:
+    explicit ObjectPool(size_t capacity) : slots(new Slot[capacity]), count(capacity), free(capacity) {
+        for (uint32_t i = 0; i < capacity; ++i) {
+            free.push(i);
+        }
+    }
+    ObjectPool(const ObjectPool&) = delete;
+    ObjectPool& operator=(const ObjectPool&) = delete;
+
+    // Constructs an object in a free slot; returns nullptr when all are in use
+    template <typename... Args>
+    T* acquire(Args&&... args) {
+        uint32_t index;
+        if (!free.pop(index)) {
+            return nullptr;
+        }
+        return new (slots[index].bytes) T(std::forward<Args>(args)...);
+    }
+
+    void release(T* object) {
+        object->~T();
+        free.push(indexOf(object));
+    }
+
+    uint32_t indexOf(const T* object) const {
+        return static_cast<uint32_t>(reinterpret_cast<const Slot*>(object) - slots.get());
+    }
+    size_t capacity() const { return count; }
+};
+
+// Sessions of a server, indexed by connection handle, client id and robot id.
+// msquic callbacks already get their session through the context pointer;
+// the indexes are for finding another connection's session, e.g. the one
+// driving a given robot. Every index is split into shards with their own
+// reader-writer lock, so lookups of different keys rarely contend, and
+// string keys are views into the session's own id strings, so a lookup with
+// a flatbuffers::String or any other view allocates nothing.
+//
+// Session must have the members
+//   Connection (a pointer, e.g. HQUIC), ClientId and RobotId (std::string)
+// and the registry owns the ids: set them through bindClient()/bindRobot().
+//
+// Lookups never return a bare pointer: the visitor runs under the shard's
+// shared lock, and destroy() takes every index's lock before it frees the
+// session, so a session cannot disappear while it is being visited.
+template <typename Session, size_t ShardCount = 16>
+class SessionRegistry {
+    static_assert((ShardCount & (ShardCount - 1)) == 0, "ShardCount must be a power of two");
+
+    template <typename Key>
+    class Index {
+        struct alignas(64) Shard {
+            mutable std::shared_mutex lock;
+            std::unordered_map<Key, Session*> map;
+        };
+        Shard shards[ShardCount];
+
+        Shard& shard(const Key& key) {
+            // Mix the hash: pointer hashes are identities with zero low bits
+            uint64_t h = std::hash<Key>{}(key) * 0x9E3779B97F4A7C15ull;
+            return shards[(h >> 32) & (ShardCount - 1)];
+        }
+        const Shard& shard(const Key& key) const { return const_cast<Index*>(this)->shard(key); }
+
+    public:
+        // A newer session takes the key over from an older one. The entry is
+        // replaced, not just its value: a string key is a view into the
+        // owner's id and must not outlive it.
+        void insert(const Key& key, Session* session) {
+            Shard& s = shard(key);
+            std::unique_lock<std::shared_mutex> guard(s.lock);
+            auto it = s.map.find(key);
+            if (it != s.map.end()) {
+                s.map.erase(it);
+            }
+            s.map.emplace(key, session);
+        }
+
+        // Removes the key only if it still belongs to this session
+        void erase(const Key& key, Session* session) {
+            Shard& s = shard(key);
+            std::unique_lock<std::shared_mutex> guard(s.lock);
+            auto it = s.map.find(key);
+            if (it != s.map.end() && it->second == session) {
+                s.map.erase(it);
+            }
+        }
+
+        template <typename Visitor>
+        bool visit(const Key& key, Visitor&& visitor) const {
+            const Shard& s = shard(key);
+            std::shared_lock<std::shared_mutex> guard(s.lock);
+            auto it = s.map.find(key);
+            if (it == s.map.end()) {
+                return false;
+            }
+            visitor(*it->second);
+            return true;
+        }
+
+        template <typename Visitor>
+        void forEach(Visitor&& visitor) const {
+            for (const Shard& s : shards) {
+                std::shared_lock<std::shared_mutex> guard(s.lock);
+                for (const auto& entry : s.map) {
+                    visitor(*entry.second);
+                }
+            }
+        }
+
+        size_t size() const {
+            size_t total = 0;
+            for (const Shard& s : shards) {
+                std::shared_lock<std::shared_mutex> guard(s.lock);
+                total += s.map.size();
+            }
+            return total;
+        }
+    };
+
+    ObjectPool<Session> pool;
+    Index<const void*> byConnection;
+    Index<std::string_view> byClient;
+    Index<std::string_view> byRobot;
+
+    void rebind(Index<std::string_view>& index, std::string& id, Session* session, std::string_view value) {
+        if (!id.empty()) {
+            index.erase(id, session);
+        }
+        id.assign(value.data(), value.size());
+        if (!id.empty()) {
+            index.insert(id, session);
+        }
+    }
+
+public:
+    explicit SessionRegistry(size_t capacity) : pool(capacity) {}
+
+    // Allocates a session from the pool; returns nullptr when the registry is full
+    template <typename... Args>
+    Session* create(Args&&... args) {
+        Session* session = pool.acquire(std::forward<Args>(args)...);
+        if (session) {
+            byConnection.insert(session->Connection, session);
+        }
+        return session;
+    }
+
+    // Unregisters the session from every index, then returns it to the pool
+    void destroy(Session* session) {
+        byConnection.erase(session->Connection, session);
+        if (!session->ClientId.empty()) {
+            byClient.erase(session->ClientId, session);
+        }
+        if (!session->RobotId.empty()) {
+            byRobot.erase(session->RobotId, session);
+        }
+        pool.release(session);
+    }
+
+    // Binding and destroy() for a session are called from the thread that
+    // owns it (its connection's msquic worker)
+    void bindClient(Session* session, std::string_view clientId) {
+        rebind(byClient, session->ClientId, session, clientId);
+    }
+    void bindRobot(Session* session, std::string_view robotId) {
+        rebind(byRobot, session->RobotId, session, robotId);
+    }
+
+    template <typename Visitor>
+    bool visitConnection(const void* connection, Visitor&& visitor) const {
+        return byConnection.visit(connection, std::forward<Visitor>(visitor));
+    }
+    template <typename Visitor>
+    bool visitClient(std::string_view clientId, Visitor&& visitor) const {
+        return byClient.visit(clientId, std::forward<Visitor>(visitor));
+    }
+    template <typename Visitor>
+    bool visitRobot(std::string_view robotId, Visitor&& visitor) const {
+        return byRobot.visit(robotId, std::forward<Visitor>(visitor));
+    }
+
+    // Visits every live session, one shard at a time under its shared lock
+    template <typename Visitor>
+    void forEach(Visitor&& visitor) const {
+        byConnection.forEach(std::forward<Visitor>(visitor));
+    }
+
+    // Stable small integer per live session, e.g. for per-session arrays
+    uint32_t slotOf(const Session* session) const { return pool.indexOf(session); }
+    size_t size() const { return byConnection.size(); }
+    size_t capacity() const { return pool.capacity(); }
+};
+
+#endif // SESSION_REGISTRY_H
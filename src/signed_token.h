@@ -0,0 +1,424 @@
+#ifndef SIGNED_TOKEN_H
+#define SIGNED_TOKEN_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <atomic>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+
+// Value of every byte as a base64url digit, 0x40 for anything else
+struct Base64UrlTable {
+    uint8_t values[256];
+    constexpr Base64UrlTable() : values() {
+        for (int c = 0; c < 256; ++c) {
+            values[c] = c >= 'A' && c <= 'Z' ? c - 'A'
+                      : c >= 'a' && c <= 'z' ? c - 'a' + 26
+                      : c >= '0' && c <= '9' ? c - '0' + 52
+                      : c == '-' ? 62
+                      : c == '_' ? 63
+                      : 0x40;
+        }
+    }
+    constexpr uint8_t operator[](uint8_t c) const { return values[c]; }
+};
+inline constexpr Base64UrlTable Base64UrlDigits{};
+
+// A token the proxy signs, carrying everything needed to check it:
+//
+//   version (1) | key id (4) | expiry, Unix seconds (8) | client_id length (1) |
+//   client_id | robot_id length (1) | robot_id | HMAC-SHA256 of all before (32)
+//
+// Integers are little-endian. On the wire it is base64url without padding.
+// Decoding fills the token's own buffer and the ids are read in place, so
+// reading one allocates nothing.
+struct SignedToken {
+    static constexpr uint8_t Version = 1;
+    static constexpr size_t HeaderSize = 1 + 4 + 8;
+    static constexpr size_t MacSize = 32;
+    static constexpr size_t MaxIdSize = 255;
+    static constexpr size_t MaxSize = HeaderSize + 2 + 2 * MaxIdSize + MacSize;
+    static constexpr size_t MaxTextSize = (MaxSize * 4 + 2) / 3;
+
+    uint8_t bytes[MaxSize];
+    size_t size{0};
+    uint32_t keyId{0};
+    uint64_t expiresSec{0};
+
+    std::string_view clientId() const { return id(HeaderSize); }
+    std::string_view robotId() const { return id(HeaderSize + 1 + bytes[HeaderSize]); }
+
+    // Decodes the wire form and splits it into fields; false unless it is
+    // canonical base64url of a well-formed token. Says nothing about the MAC.
+    bool parse(const char* text, size_t length) {
+        if (length > MaxTextSize || length % 4 == 1) {
+            return false;
+        }
+        uint8_t invalid = 0;
+        size_t out = 0;
+        size_t i = 0;
+        for (; i + 4 <= length; i += 4) {
+            uint8_t a = Base64UrlDigits[static_cast<uint8_t>(text[i])];
+            uint8_t b = Base64UrlDigits[static_cast<uint8_t>(text[i + 1])];
+            uint8_t c = Base64UrlDigits[static_cast<uint8_t>(text[i + 2])];
+            uint8_t d = Base64UrlDigits[static_cast<uint8_t>(text[i + 3])];
+            invalid |= a | b | c | d;
+            bytes[out++] = static_cast<uint8_t>(a << 2 | (b & 63) >> 4);
+            bytes[out++] = static_cast<uint8_t>(b << 4 | (c & 63) >> 2);
+            bytes[out++] = static_cast<uint8_t>(c << 6 | (d & 63));
+        }
+        if (i < length) {
+            // Two or three digits left; the bits past the last byte must be zero
+            uint8_t a = Base64UrlDigits[static_cast<uint8_t>(text[i])];
+            uint8_t b = Base64UrlDigits[static_cast<uint8_t>(text[i + 1])];
+            invalid |= a | b;
+            bytes[out++] = static_cast<uint8_t>(a << 2 | (b & 63) >> 4);
+            if (i + 3 == length) {
+                uint8_t c = Base64UrlDigits[static_cast<uint8_t>(text[i + 2])];
+                invalid |= c;
+                bytes[out++] = static_cast<uint8_t>(b << 4 | (c & 63) >> 2);
+                invalid |= (c & 3) ? 0x40 : 0;
+            } else {
+                invalid |= (b & 15) ? 0x40 : 0;
+            }
+        }
+        if (invalid & 0x40) {
+            return false;
+        }
+        size = out;
+        return split();
+    }
+
+    // The signed part, and the MAC that closes it
+    size_t signedSize() const { return size - MacSize; }
+    const uint8_t* mac() const { return bytes + signedSize(); }
+
+    // Lays out a token to sign; false if an id is too long
+    bool build(uint32_t key, uint64_t expires, std::string_view client, std::string_view robot) {
+        if (client.size() > MaxIdSize || robot.size() > MaxIdSize) {
+            return false;
+        }
+        bytes[0] = Version;
+        for (int b = 0; b < 4; ++b) {
+            bytes[1 + b] = static_cast<uint8_t>(key >> (8 * b));
+        }
+        for (int b = 0; b < 8; ++b) {
+            bytes[5 + b] = static_cast<uint8_t>(expires >> (8 * b));
+        }
+        size_t at = HeaderSize;
+        bytes[at++] = static_cast<uint8_t>(client.size());
+        memcpy(bytes + at, client.data(), client.size());
+        at += client.size();
+        bytes[at++] = static_cast<uint8_t>(robot.size());
+        memcpy(bytes + at, robot.data(), robot.size());
+        size = at + robot.size() + MacSize;
+        return split();
+    }
+
+    std::string text() const {
+        static const char digits[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+        std::string out;
+        out.reserve((size * 4 + 2) / 3);
+        size_t i = 0;
+        for (; i + 3 <= size; i += 3) {
+            uint32_t group = bytes[i] << 16 | bytes[i + 1] << 8 | bytes[i + 2];
+            out += digits[group >> 18];
+            out += digits[group >> 12 & 63];
+            out += digits[group >> 6 & 63];
+            out += digits[group & 63];
+        }
+        if (i < size) {
+            uint32_t group = bytes[i] << 16 | (i + 1 < size ? bytes[i + 1] << 8 : 0);
+            out += digits[group >> 18];
+            out += digits[group >> 12 & 63];
+            if (i + 1 < size) {
+                out += digits[group >> 6 & 63];
+            }
+        }
+        return out;
+    }
+
+private:
+    std::string_view id(size_t at) const {
+        return std::string_view(reinterpret_cast<const char*>(bytes + at + 1), bytes[at]);
+    }
+
+    bool split() {
+        if (size < HeaderSize + 2 + MacSize || bytes[0] != Version) {
+            return false;
+        }
+        keyId = 0;
+        for (int b = 3; b >= 0; --b) {
+            keyId = keyId << 8 | bytes[1 + b];
+        }
+        expiresSec = 0;
+        for (int b = 7; b >= 0; --b) {
+            expiresSec = expiresSec << 8 | bytes[5 + b];
+        }
+        // Both ids fill the signed part exactly
+        size_t robotAt = HeaderSize + 1 + bytes[HeaderSize];
+        return robotAt < signedSize() && robotAt + 1 + bytes[robotAt] == signedSize();
+    }
+};
+
+// One HMAC-SHA256 key. The hashes of its inner and outer pads are taken
+// once, so a MAC costs two state copies and the hashes of the message and
+// of the inner digest, instead of setting up HMAC for every token.
+class TokenKey {
+    static constexpr size_t BlockSize = 64;
+
+    uint32_t keyId;
+    EVP_MD_CTX* inner;
+    EVP_MD_CTX* outer;
+
+public:
+    // Keys shorter than this are refused
+    static constexpr size_t MinSize = 16;
+
+    TokenKey(uint32_t id, const uint8_t* key, size_t length)
+        : keyId(id), inner(EVP_MD_CTX_new()), outer(EVP_MD_CTX_new()) {
+        uint8_t block[BlockSize] = {};
+        unsigned int digestLength = 0;
+        if (length > BlockSize) {
+            EVP_Digest(key, length, block, &digestLength, EVP_sha256(), nullptr);
+        } else {
+            memcpy(block, key, length);
+        }
+        uint8_t innerPad[BlockSize];
+        uint8_t outerPad[BlockSize];
+        for (size_t i = 0; i < BlockSize; ++i) {
+            innerPad[i] = block[i] ^ 0x36;
+            outerPad[i] = block[i] ^ 0x5c;
+        }
+        bool ok = length >= MinSize && inner && outer &&
+                  EVP_DigestInit_ex(inner, EVP_sha256(), nullptr) && EVP_DigestUpdate(inner, innerPad, BlockSize) &&
+                  EVP_DigestInit_ex(outer, EVP_sha256(), nullptr) && EVP_DigestUpdate(outer, outerPad, BlockSize);
+        OPENSSL_cleanse(block, sizeof(block));
+        OPENSSL_cleanse(innerPad, sizeof(innerPad));
+        OPENSSL_cleanse(outerPad, sizeof(outerPad));
+        if (!ok) {
+            EVP_MD_CTX_free(inner);
+            EVP_MD_CTX_free(outer);
+            inner = outer = nullptr;
+        }
+    }
+
+    ~TokenKey() {
+        EVP_MD_CTX_free(inner);
+        EVP_MD_CTX_free(outer);
+    }
+
+    TokenKey(const TokenKey&) = delete;
+    TokenKey& operator=(const TokenKey&) = delete;
+
+    bool valid() const { return inner != nullptr; }
+    uint32_t id() const { return keyId; }
+
+    // Safe from any number of threads: each one hashes in a context of its own
+    bool mac(const uint8_t* data, size_t length, uint8_t out[SignedToken::MacSize]) const {
+        static thread_local std::unique_ptr<EVP_MD_CTX, void (*)(EVP_MD_CTX*)> work(EVP_MD_CTX_new(), EVP_MD_CTX_free);
+        uint8_t digest[SignedToken::MacSize];
+        unsigned int digestLength = 0;
+        return work && EVP_MD_CTX_copy_ex(work.get(), inner) && EVP_DigestUpdate(work.get(), data, length) &&
+               EVP_DigestFinal_ex(work.get(), digest, &digestLength) &&
+               EVP_MD_CTX_copy_ex(work.get(), outer) && EVP_DigestUpdate(work.get(), digest, sizeof(digest)) &&
+               EVP_DigestFinal_ex(work.get(), out, &digestLength);
+    }
+};
+
+// The token a connection last presented and the claims it proved. The
+// commands that follow carry the same token, and checking one that matches
+// it takes a compare instead of a MAC, until the token expires or the keys
+// or revocations change.
+struct VerifiedToken {
+    SignedToken token;
+    std::string text;
+    uint64_t generation{0};     // of the keys it was checked with; 0 if none
+};
+
+// The keys the proxy signs and checks tokens with. One key signs; the
+// others are only accepted, so keys rotate without a flag day: every proxy
+// first learns the new key, then signs with it, and the old key is retired
+// once the tokens it signed have expired. Checking a token reads an
+// immutable snapshot of the keys and needs nothing from any other proxy.
+//
+// A token can also be revoked before it expires. Revocations are kept only
+// by the keyring that made them, until the token would have expired anyway.
+class TokenKeyring {
+    struct Keys {
+        std::vector<std::shared_ptr<const TokenKey>> accepted;
+        std::shared_ptr<const TokenKey> signing;
+        std::unordered_map<uint64_t, uint64_t> revoked;     // revocation id to the token's expiry
+
+        const TokenKey* find(uint32_t id) const {
+            for (const auto& key : accepted) {
+                if (key->id() == id) {
+                    return key.get();
+                }
+            }
+            return nullptr;
+        }
+    };
+
+    std::shared_ptr<const Keys> current;
+    std::atomic<uint64_t> generation{1};    // bumped by every change
+    std::mutex writers;
+
+    // The first bytes of the MAC; only the key holder can make two tokens share them
+    static uint64_t RevocationId(const SignedToken& token) {
+        uint64_t id;
+        memcpy(&id, token.mac(), sizeof(id));
+        return id;
+    }
+
+    template <typename Change>
+    bool update(Change&& change) {
+        std::lock_guard<std::mutex> guard(writers);
+        std::shared_ptr<Keys> next = std::make_shared<Keys>(*std::atomic_load(&current));
+        if (!change(*next)) {
+            return false;
+        }
+        std::atomic_store(&current, std::shared_ptr<const Keys>(std::move(next)));
+        generation.fetch_add(1, std::memory_order_release);
+        return true;
+    }
+
+public:
+    enum class Result {
+        Valid,
+        Malformed,
+        UnknownKey,     // signed with a key this proxy never had or has retired
+        BadSignature,
+        Revoked,
+        Expired
+    };
+
+    TokenKeyring() : current(std::make_shared<Keys>()) {}
+
+    // Accepts tokens signed with the key from now on, and signs with it if
+    // Signing is set. False if the id is taken or the key is too short.
+    bool add(uint32_t id, const uint8_t* key, size_t length, bool signing) {
+        auto added = std::make_shared<const TokenKey>(id, key, length);
+        if (!added->valid()) {
+            return false;
+        }
+        return update([&](Keys& keys) {
+            if (keys.find(id)) {
+                return false;
+            }
+            keys.accepted.push_back(added);
+            if (signing) {
+                keys.signing = added;
+            }
+            return true;
+        });
+    }
+
+    // Signs new tokens with a key already accepted
+    bool use(uint32_t id) {
+        return update([id](Keys& keys) {
+            for (const auto& key : keys.accepted) {
+                if (key->id() == id) {
+                    keys.signing = key;
+                    return true;
+                }
+            }
+            return false;
+        });
+    }
+
+    // Stops accepting a key; the signing key cannot be retired
+    bool retire(uint32_t id) {
+        return update([id](Keys& keys) {
+            for (auto it = keys.accepted.begin(); it != keys.accepted.end(); ++it) {
+                if ((*it)->id() == id && *it != keys.signing) {
+                    keys.accepted.erase(it);
+                    return true;
+                }
+            }
+            return false;
+        });
+    }
+
+    // Refuses a valid token from now on, and drops the revocations of tokens
+    // that have expired since. False if the token is not valid.
+    bool revoke(const char* text, size_t length, uint64_t nowSec) {
+        SignedToken token;
+        if (verify(text, length, nowSec, token) != Result::Valid) {
+            return false;
+        }
+        return update([&](Keys& keys) {
+            for (auto it = keys.revoked.begin(); it != keys.revoked.end();) {
+                it = it->second <= nowSec ? keys.revoked.erase(it) : std::next(it);
+            }
+            keys.revoked[RevocationId(token)] = token.expiresSec;
+            return true;
+        });
+    }
+
+    bool canSign() const { return std::atomic_load(&current)->signing != nullptr; }
+    size_t size() const { return std::atomic_load(&current)->accepted.size(); }
+    size_t revoked() const { return std::atomic_load(&current)->revoked.size(); }
+
+    // The wire form of a token for the ids, valid until ExpiresSec (Unix
+    // time); empty without a signing key or when an id is too long
+    std::string sign(std::string_view clientId, std::string_view robotId, uint64_t expiresSec) const {
+        std::shared_ptr<const Keys> keys = std::atomic_load(&current);
+        SignedToken token;
+        if (!keys->signing || !token.build(keys->signing->id(), expiresSec, clientId, robotId) ||
+            !keys->signing->mac(token.bytes, token.signedSize(), token.bytes + token.signedSize())) {
+            return std::string();
+        }
+        return token.text();
+    }
+
+    // Checks a token in wire form at NowSec (Unix time). Token holds the
+    // decoded claims, which are only to be trusted when this returns Valid.
+    Result verify(const char* text, size_t length, uint64_t nowSec, SignedToken& token) const {
+        if (!token.parse(text, length)) {
+            return Result::Malformed;
+        }
+        std::shared_ptr<const Keys> keys = std::atomic_load(&current);
+        const TokenKey* key = keys->find(token.keyId);
+        if (!key) {
+            return Result::UnknownKey;
+        }
+        uint8_t expected[SignedToken::MacSize];
+        if (!key->mac(token.bytes, token.signedSize(), expected) ||
+            CRYPTO_memcmp(expected, token.mac(), SignedToken::MacSize) != 0) {
+            return Result::BadSignature;
+        }
+        if (!keys->revoked.empty() && keys->revoked.count(RevocationId(token)) != 0) {
+            return Result::Revoked;
+        }
+        return nowSec < token.expiresSec ? Result::Valid : Result::Expired;
+    }
+
+    // As above, but a token identical to the one Last holds is not checked
+    // again. Last then holds this token, or nothing if it is not valid.
+    Result verify(const char* text, size_t length, uint64_t nowSec, VerifiedToken& last) const {
+        uint64_t current = generation.load(std::memory_order_acquire);
+        // Last is the connection's own; timing tells it nothing it did not send
+        if (last.generation == current && length == last.text.size() && memcmp(text, last.text.data(), length) == 0) {
+            return nowSec < last.token.expiresSec ? Result::Valid : Result::Expired;
+        }
+        Result result = verify(text, length, nowSec, last.token);
+        if (result == Result::Valid) {
+            last.text.assign(text, length);
+            last.generation = current;
+        } else {
+            last.generation = 0;
+        }
+        return result;
+    }
+};
+
+#endif // SIGNED_TOKEN_H
@@ -1,5 +1,6 @@
 #include <iostream>
 #include "teleop_generated.h"
+#include "envelope.h"
 
 int main() {
     // Create a FlatBufferBuilder to store our data
@@ -8,23 +9,25 @@ int main() {
     // Create a control command
     auto command = Teleop::CreateControlCommand(
         builder,
+        Teleop::CommandType_MOVE,
         1.0f,    // linear_velocity
         0.5f,    // angular_velocity
+        0,       // target_position
         123456   // timestamp
     );
-    builder.Finish(command);
+    FinishEnvelope(builder, command);
 
     // Get the buffer and verify it
     uint8_t* buf = builder.GetBufferPointer();
     int size = builder.GetSize();
 
     // Verify and read back the data
-    auto verifier = flatbuffers::Verifier(buf, size);
-    auto cmd = flatbuffers::GetRoot<Teleop::ControlCommand>(buf);
-    if (!cmd->Verify(verifier)) {
+    auto envelope = OpenEnvelope(buf, size);
+    if (!envelope || envelope->payload_type() != Teleop::Payload_ControlCommand) {
         std::cerr << "Invalid buffer!" << std::endl;
         return 1;
     }
+    auto cmd = envelope->payload_as_ControlCommand();
 
     // Read back the data
     std::cout << "Control Command:" << std::endl;
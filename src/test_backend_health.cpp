@@ -0,0 +1,182 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include "backend_health.h"
+
+static Backend Make(const std::string& name) {
+    Backend backend;
+    if (!ParseBackend(name, backend)) {
+        std::cerr << "Cannot parse " << name << std::endl;
+        std::exit(1);
+    }
+    return backend;
+}
+
+static BackendStatus Status(const BackendHealth& health, const std::string& name, uint64_t nowUs) {
+    for (const BackendStatus& status : health.statuses(nowUs)) {
+        if (status.name == name) {
+            return status;
+        }
+    }
+    std::cerr << name << " is not tracked" << std::endl;
+    std::exit(1);
+}
+
+// A robot whose owner on the ring is the given backend
+static std::string RobotOwnedBy(const HashRing& ring, const std::string& name) {
+    for (int r = 0; ; ++r) {
+        std::string robot = "robot-" + std::to_string(r);
+        if (ring.route(robot)->name == name) {
+            return robot;
+        }
+    }
+}
+
+int main() {
+    const std::vector<std::string> names{"10.0.0.1:4433", "10.0.0.2:4433", "10.0.0.3:4433", "10.0.0.4:4433"};
+    HashRing ring;
+    BackendHealth health;
+    HealthOptions options;
+    health.setOptions(options);
+    for (const std::string& name : names) {
+        ring.add(Make(name));
+        health.track(name);
+    }
+    uint64_t now = 1000000;
+    for (const std::string& name : names) {
+        health.recordProbe(name, 5000, 10, 1024, 0);
+    }
+
+    // Skipping an unavailable owner moves only its robots, always to the same backend
+    std::string robot = RobotOwnedBy(ring, names[0]);
+    const Backend* fallback = ring.route(robot, [&](const Backend& b) { return b.name != names[0]; });
+    if (health.select(ring, robot, RoutingPolicy::Affinity, now)->name != names[0] || !fallback ||
+        fallback->name == names[0]) {
+        std::cerr << "Healthy owner was not chosen" << std::endl;
+        return 1;
+    }
+
+    // Failed probes in a row take a backend down; answered ones bring it back
+    for (uint32_t i = 0; i < options.unhealthyThreshold; ++i) {
+        health.recordFailure(names[0]);
+    }
+    if (Status(health, names[0], now).up ||
+        health.select(ring, robot, RoutingPolicy::Affinity, now)->name != fallback->name) {
+        std::cerr << "Down backend still takes sessions" << std::endl;
+        return 1;
+    }
+    if (Status(health, names[0], now).errorRate <= 0 || Status(health, names[0], now).failedProbes != 3) {
+        std::cerr << "Failed probes were not counted" << std::endl;
+        return 1;
+    }
+    for (uint32_t i = 0; i < options.healthyThreshold; ++i) {
+        health.recordProbe(names[0], 5000, 10, 1024, 0);
+    }
+    if (!Status(health, names[0], now).up || health.select(ring, robot, RoutingPolicy::Affinity, now)->name != names[0]) {
+        std::cerr << "Recovered backend does not take sessions" << std::endl;
+        return 1;
+    }
+
+    // A latency outlier is ejected for ejectionMs, then returns; a second ejection lasts twice as long
+    for (int i = 0; i < 20; ++i) {
+        health.recordProbe(names[1], 80000, 10, 1024, 0);
+    }
+    health.evaluate(now);
+    if (!Status(health, names[1], now).ejected || Status(health, names[0], now).ejected) {
+        std::cerr << "Latency outlier was not ejected" << std::endl;
+        return 1;
+    }
+    health.evaluate(now + options.ejectionMs * 1000ull - 1);
+    if (!Status(health, names[1], now + options.ejectionMs * 1000ull - 1).ejected) {
+        std::cerr << "Ejection ended early" << std::endl;
+        return 1;
+    }
+    now += options.ejectionMs * 1000ull;
+    health.evaluate(now);
+    if (Status(health, names[1], now).ejected) {
+        std::cerr << "Ejection did not end" << std::endl;
+        return 1;
+    }
+    now += 1000000;
+    health.recordProbe(names[1], 80000, 10, 1024, 0);
+    health.evaluate(now);
+    if (!Status(health, names[1], now + 2 * options.ejectionMs * 1000ull - 1).ejected ||
+        Status(health, names[1], now).ejections != 2) {
+        std::cerr << "Repeated ejection did not back off" << std::endl;
+        return 1;
+    }
+
+    // Outlier ejection never takes out more than maxEjectedPercent of the backends
+    HashRing five;
+    BackendHealth capped;
+    HealthOptions cap;
+    cap.maxEjectedPercent = 20;
+    capped.setOptions(cap);
+    for (int b = 0; b < 5; ++b) {
+        std::string name = "10.2.0." + std::to_string(b + 1) + ":4433";
+        five.add(Make(name));
+        capped.track(name);
+        capped.recordProbe(name, b < 3 ? 1000 : 100000 + b, 10, 1024, 0);
+    }
+    capped.evaluate(now);
+    size_t ejectedCount = 0;
+    for (const BackendStatus& status : capped.statuses(now)) {
+        ejectedCount += status.ejected;
+    }
+    if (ejectedCount != 1 || !Status(capped, "10.2.0.5:4433", now).ejected) {
+        std::cerr << ejectedCount << " of 5 backends ejected" << std::endl;
+        return 1;
+    }
+
+    // A far but idle server wins over a close one with a backlog, and an
+    // overloaded one takes no new sessions at all
+    HashRing pair;
+    BackendHealth load;
+    pair.add(Make("10.1.0.1:4433"));
+    pair.add(Make("10.1.0.2:4433"));
+    load.track("10.1.0.1:4433");
+    load.track("10.1.0.2:4433");
+    load.recordProbe("10.1.0.1:4433", 2000, 10, 1024, 20);
+    load.recordProbe("10.1.0.2:4433", 30000, 10, 1024, 0);
+    if (load.select(pair, "robot-1", RoutingPolicy::Latency, now)->name != "10.1.0.2:4433") {
+        std::cerr << "Close server with a backlog beat an idle one" << std::endl;
+        return 1;
+    }
+    load.recordProbe("10.1.0.1:4433", 2000, 10, 1024, 0);
+    if (load.select(pair, "robot-1", RoutingPolicy::Latency, now)->name != "10.1.0.1:4433") {
+        std::cerr << "Idle close server was not preferred" << std::endl;
+        return 1;
+    }
+    load.recordProbe("10.1.0.1:4433", 2000, 1000, 1024, 0);
+    std::string owned = RobotOwnedBy(pair, "10.1.0.1:4433");
+    if (!Status(load, "10.1.0.1:4433", now).overloaded ||
+        load.select(pair, owned, RoutingPolicy::Affinity, now)->name != "10.1.0.2:4433") {
+        std::cerr << "Overloaded owner still takes sessions" << std::endl;
+        return 1;
+    }
+
+    // With nothing available a session still goes somewhere, preferring backends that are up
+    load.recordProbe("10.1.0.2:4433", 2000, 0, 1024, options.overloadedQueueDepth);
+    if (load.select(pair, owned, RoutingPolicy::Affinity, now)->name != "10.1.0.1:4433") {
+        std::cerr << "No backend for an overloaded pool" << std::endl;
+        return 1;
+    }
+    for (uint32_t i = 0; i < options.unhealthyThreshold; ++i) {
+        load.recordFailure("10.1.0.1:4433");
+    }
+    if (load.select(pair, owned, RoutingPolicy::Latency, now)->name != "10.1.0.2:4433") {
+        std::cerr << "Down backend was chosen over an overloaded one" << std::endl;
+        return 1;
+    }
+
+    // Results for backends no longer tracked are dropped
+    load.forget("10.1.0.1:4433");
+    load.recordProbe("10.1.0.1:4433", 2000, 0, 1024, 0);
+    if (load.statuses(now).size() != 1) {
+        std::cerr << "Forgotten backend came back" << std::endl;
+        return 1;
+    }
+
+    std::cout << "Backend health OK" << std::endl;
+    return 0;
+}
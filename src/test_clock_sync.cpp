@@ -0,0 +1,67 @@
+#include <iostream>
+#include <cstdlib>
+#include <random>
+#include "clock_sync.h"
+
+// Simulated peer whose clock runs `offsetUs` ahead and drifts by `driftPpm`
+struct PeerClock {
+    double offsetUs;
+    double driftPpm;
+    uint64_t at(uint64_t localUs) const {
+        return static_cast<uint64_t>(static_cast<double>(localUs) + offsetUs +
+                                     driftPpm * 1e-6 * static_cast<double>(localUs - 1000000000000ull));
+    }
+};
+
+int main() {
+    const PeerClock peer{5000000.0, 80.0};  // 5 s ahead, gaining 80 us per second
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<uint64_t> baseDelay(2000, 4000);
+    std::uniform_int_distribution<int> spike(0, 9);
+    std::uniform_int_distribution<uint64_t> spikeDelay(10000, 50000);
+
+    // One exchange per second for two minutes with asymmetric, occasionally
+    // queued paths; the client turns each request around in 50 us
+    ClockSync clock;
+    uint64_t now = 1000000000000ull;
+    for (int i = 0; i < 120; ++i) {
+        uint64_t forward = baseDelay(rng) + (spike(rng) == 0 ? spikeDelay(rng) : 0);
+        uint64_t back = baseDelay(rng) + (spike(rng) == 0 ? spikeDelay(rng) : 0);
+        uint64_t t1 = now;
+        uint64_t t2 = peer.at(t1 + forward);
+        uint64_t t3 = t2 + 50;
+        uint64_t t4 = t1 + forward + 50 + back;
+        clock.addSample(t1, t2, t3, t4);
+        now += 1000000;
+    }
+
+    // Half the path asymmetry (at most ~1 ms here) bounds the error
+    uint64_t probe = now + 500000;
+    int64_t expected = static_cast<int64_t>(peer.at(probe) - probe);
+    int64_t error = clock.offsetAt(probe) - expected;
+    if (std::llabs(error) > 1500) {
+        std::cerr << "Offset error " << error << " us (estimated " << clock.offsetAt(probe)
+                  << ", expected " << expected << ")" << std::endl;
+        return 1;
+    }
+    if (clock.driftPpm() < 40.0 || clock.driftPpm() > 120.0) {
+        std::cerr << "Drift estimate " << clock.driftPpm() << " ppm, expected ~80" << std::endl;
+        return 1;
+    }
+
+    // A peer timestamp maps back into the local timebase
+    uint64_t local = clock.toLocal(peer.at(probe), probe);
+    if (std::llabs(static_cast<int64_t>(local - probe)) > 1500) {
+        std::cerr << "toLocal off by " << static_cast<int64_t>(local - probe) << " us" << std::endl;
+        return 1;
+    }
+
+    // Impossible samples are rejected
+    if (clock.addSample(100, 200, 150, 300) || clock.addSample(300, 200, 250, 100)) {
+        std::cerr << "Out-of-order sample accepted" << std::endl;
+        return 1;
+    }
+
+    std::cout << "Clock sync OK (offset error " << error << " us, drift " << clock.driftPpm() << " ppm)" << std::endl;
+    return 0;
+}
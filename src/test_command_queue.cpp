@@ -0,0 +1,121 @@
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include "command_queue.h"
+
+static ControlSetpoint Setpoint(Teleop::CommandType type, uint32_t sequence, float linear = 0.0f) {
+    ControlSetpoint setpoint{};
+    setpoint.type = type;
+    setpoint.sequence = sequence;
+    setpoint.linearVelocity = linear;
+    return setpoint;
+}
+
+int main() {
+    CommandQueue queue(4, 4);
+    int32_t a = queue.openMailbox();
+    int32_t b = queue.openMailbox();
+    std::vector<ControlSetpoint> seen;
+    auto collect = [&seen](const ControlSetpoint& setpoint) { seen.push_back(setpoint); };
+
+    // Setpoints overwrite each other; only the newest per connection is delivered
+    for (uint32_t i = 1; i <= 10; ++i) {
+        queue.publish(a, Setpoint(Teleop::CommandType_MOVE, i, static_cast<float>(i)));
+    }
+    queue.publish(b, Setpoint(Teleop::CommandType_MOVE, 1, 42.0f));
+    queue.drain(collect);
+    if (seen.size() != 2 || seen[0].sequence != 10 || seen[0].linearVelocity != 10.0f ||
+        seen[1].linearVelocity != 42.0f || queue.overwrittenCount() != 9) {
+        std::cerr << "Latest-value overwrite failed (" << seen.size() << " delivered)" << std::endl;
+        return 1;
+    }
+
+    // Stops are delivered ahead of setpoints, and a setpoint sent before a
+    // stop from the same connection is dropped
+    seen.clear();
+    queue.publish(a, Setpoint(Teleop::CommandType_MOVE, 11));
+    queue.publish(a, Setpoint(Teleop::CommandType_EMERGENCY_STOP, 12));
+    queue.publish(b, Setpoint(Teleop::CommandType_MOVE, 2));
+    queue.drain(collect);
+    if (seen.size() != 2 || seen[0].type != Teleop::CommandType_EMERGENCY_STOP || seen[1].mailbox != static_cast<uint32_t>(b)) {
+        std::cerr << "Urgent ordering failed (" << seen.size() << " delivered)" << std::endl;
+        return 1;
+    }
+
+    // Every stop is delivered; past the urgent queue's capacity they latch
+    seen.clear();
+    for (uint32_t i = 0; i < 6; ++i) {
+        queue.publish(b, Setpoint(i == 5 ? Teleop::CommandType_EMERGENCY_STOP : Teleop::CommandType_STOP, 3 + i));
+    }
+    queue.drain(collect);
+    if (seen.size() != 5 || seen[0].type != Teleop::CommandType_EMERGENCY_STOP || seen[0].mailbox != static_cast<uint32_t>(b)) {
+        std::cerr << "Urgent overflow failed (" << seen.size() << " delivered)" << std::endl;
+        return 1;
+    }
+
+    // Overflowing stops from two robots each latch for their own robot, the
+    // strongest one per robot, and supersede that robot's older setpoints
+    seen.clear();
+    for (uint32_t i = 0; i < 4; ++i) {
+        queue.publish(a, Setpoint(Teleop::CommandType_STOP, 30 + i));
+    }
+    queue.publish(b, Setpoint(Teleop::CommandType_MOVE, 40));
+    queue.publish(b, Setpoint(Teleop::CommandType_EMERGENCY_STOP, 41));
+    queue.publish(b, Setpoint(Teleop::CommandType_STOP, 42));
+    queue.publish(a, Setpoint(Teleop::CommandType_STOP, 34));
+    queue.drain(collect);
+    bool latchedB = seen.size() == 6 && seen[0].type == Teleop::CommandType_EMERGENCY_STOP && seen[0].sequence == 41 &&
+                    seen[0].mailbox == static_cast<uint32_t>(b) && seen[0].generation == queue.mailboxGeneration(b);
+    bool latchedA = seen.size() == 6 && seen[1].type == Teleop::CommandType_STOP && seen[1].sequence == 34 &&
+                    seen[1].mailbox == static_cast<uint32_t>(a) && seen[1].generation == queue.mailboxGeneration(a);
+    if (!latchedA || !latchedB || seen.back().type != Teleop::CommandType_STOP) {
+        std::cerr << "Latched stops were not delivered to their own robots (" << seen.size() << " delivered)" << std::endl;
+        return 1;
+    }
+
+    // Nothing queued from a closed connection survives, and its slot is reused
+    seen.clear();
+    queue.publish(a, Setpoint(Teleop::CommandType_MOVE, 20));
+    queue.closeMailbox(a);
+    queue.drain(collect);
+    int32_t c = queue.openMailbox();
+    if (!seen.empty() || c < 0) {
+        std::cerr << "Closed mailbox delivered " << seen.size() << " commands" << std::endl;
+        return 1;
+    }
+
+    // A producer on another thread wakes the waiting consumer. Setpoints
+    // arrive in order; every stop arrives, possibly after a later setpoint
+    CommandQueue shared(4, 256);
+    int32_t d = shared.openMailbox();
+    const uint32_t count = 10000;
+    std::thread producer([&shared, d]() {
+        for (uint32_t i = 1; i <= count; ++i) {
+            shared.publish(d, Setpoint(i % 100 == 0 ? Teleop::CommandType_STOP : Teleop::CommandType_MOVE, i));
+        }
+    });
+    uint32_t lastMove = 0;
+    uint32_t stops = 0;
+    bool ordered = true;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (stops < count / 100 && std::chrono::steady_clock::now() < deadline) {
+        shared.drain([&](const ControlSetpoint& setpoint) {
+            if (setpoint.type == Teleop::CommandType_STOP) {
+                ++stops;
+                return;
+            }
+            ordered = ordered && setpoint.sequence > lastMove;
+            lastMove = setpoint.sequence;
+        });
+        shared.wait(std::chrono::milliseconds(10));
+    }
+    producer.join();
+    if (!ordered || stops != count / 100) {
+        std::cerr << "Concurrent handoff: ordered " << ordered << ", stops " << stops << std::endl;
+        return 1;
+    }
+
+    std::cout << "Command queue OK" << std::endl;
+    return 0;
+}
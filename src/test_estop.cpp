@@ -0,0 +1,94 @@
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <functional>
+#include "server.h"
+#include "client.h"
+
+// Emergency stop latency while the client saturates its connection with
+// sensor data on the telemetry stream. Every stop must reach the server's
+// control thread, and promptly.
+// Usage: test_estop [stops]
+
+static bool WaitFor(const std::function<bool()>& done, std::chrono::seconds timeout) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (!done()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    const uint64_t stops = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 50;
+    // Generous enough for a loaded CI machine; a stop stuck behind the
+    // telemetry backlog takes far longer
+    const uint64_t maxP99Us = 50000;
+
+    QuicServer server;
+    server.SetVerbose(false);
+    if (!server.Initialize() || !server.Start()) {
+        return 1;
+    }
+    std::thread control([&server]() { server.Run(); });
+
+    QuicClient client;
+    client.SetDuplicateStops(true);
+    bool ok = client.Initialize() && client.Connect("127.0.0.1") &&
+              WaitFor([&client]() { return client.IsConnected(); }, std::chrono::seconds(5));
+    if (!ok) {
+        std::cerr << "Connection failed" << std::endl;
+        server.Stop();
+        control.join();
+        return 1;
+    }
+
+    // Keep the telemetry stream's send queue full for the whole test
+    std::atomic<bool> saturating{true};
+    uint64_t sensorSent = 0;
+    std::thread sensors([&]() {
+        while (saturating.load(std::memory_order_relaxed)) {
+            if (client.SendSensorData(1.0f, 2.0f, 0.9f)) {
+                ++sensorSent;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    uint64_t sentStops = 0;
+    for (uint64_t i = 0; i < stops; ++i) {
+        sentStops += client.SendStop(i % 2 ? Teleop::CommandType_STOP : Teleop::CommandType_EMERGENCY_STOP);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    bool delivered = WaitFor([&]() { return server.GetStopLatency().snapshot().count >= stops; },
+                             std::chrono::seconds(10));
+    saturating = false;
+    sensors.join();
+    server.Stop();
+    control.join();
+
+    LatencySnapshot latency = server.GetStopLatency().snapshot();
+    std::cout << "Sensor messages: " << sensorSent << " sent, " << server.GetSensorMessagesReceived() << " received" << std::endl;
+    std::cout << "Stops: " << sentStops << " sent, " << latency.count << " applied, latency us p50 " << latency.p50
+              << " p99 " << latency.p99 << " max " << latency.max << std::endl;
+
+    if (sentStops != stops || !delivered) {
+        std::cerr << "Not every stop was applied" << std::endl;
+        return 1;
+    }
+    if (latency.count != stops) {
+        std::cerr << "Duplicate stops applied" << std::endl;
+        return 1;
+    }
+    if (latency.p99 > maxP99Us) {
+        std::cerr << "Stop latency p99 " << latency.p99 << " us exceeds " << maxP99Us << " us" << std::endl;
+        return 1;
+    }
+    std::cout << "Emergency stop OK" << std::endl;
+    return 0;
+}
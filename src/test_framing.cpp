@@ -0,0 +1,55 @@
+#include <iostream>
+#include <vector>
+#include "framing.h"
+
+// Feeds the bytes one at a time and returns the lengths of the frames decoded
+static bool Decode(const std::vector<uint8_t>& wire, std::vector<size_t>& frames, size_t maxLength = 1 << 20) {
+    FrameDecoder decoder(maxLength);
+    for (uint8_t byte : wire) {
+        if (!decoder.feed(&byte, 1, [&frames](const uint8_t*, size_t length) { frames.push_back(length); })) {
+            return false;
+        }
+    }
+    return decoder.idle();
+}
+
+int main() {
+    // Lengths at every prefix size round-trip, whole or byte by byte
+    const uint32_t lengths[] = {0, 1, 127, 128, 300, 16383, 16384, 70000};
+    std::vector<uint8_t> wire;
+    for (uint32_t length : lengths) {
+        uint8_t prefix[Framing::MaxPrefixLength];
+        wire.insert(wire.end(), prefix, prefix + Framing::EncodePrefix(length, prefix));
+        wire.insert(wire.end(), length, static_cast<uint8_t>(length));
+    }
+    std::vector<size_t> frames;
+    FrameDecoder whole(1 << 20);
+    bool ok = whole.feed(wire.data(), wire.size(), [&frames](const uint8_t* data, size_t length) {
+        frames.push_back(length == 0 || data[length - 1] == static_cast<uint8_t>(length) ? length : ~size_t(0));
+    });
+    if (!ok || frames.size() != sizeof(lengths) / sizeof(lengths[0]) || frames[7] != 70000 ||
+        !Decode(wire, frames) || frames.size() != 2 * sizeof(lengths) / sizeof(lengths[0])) {
+        std::cerr << "Frames did not round-trip" << std::endl;
+        return 1;
+    }
+
+    // The largest 32-bit length fits in five bytes
+    uint8_t prefix[Framing::MaxPrefixLength];
+    if (Framing::EncodePrefix(0xffffffff, prefix) != 5 || prefix[4] != 0x0f) {
+        std::cerr << "Prefix of the largest length is wrong" << std::endl;
+        return 1;
+    }
+
+    // A fifth byte carrying more than four bits, or a continuation, overflows
+    // 32 bits and is refused, as is a frame over the limit
+    frames.clear();
+    if (Decode({0x80, 0x80, 0x80, 0x80, 0x10}, frames) || Decode({0x81, 0x80, 0x80, 0x80, 0x70, 0x00}, frames) ||
+        Decode({0x80, 0x80, 0x80, 0x80, 0x80, 0x00}, frames) || !Decode({0x81, 0x80, 0x80, 0x80, 0x00, 0x2a}, frames) ||
+        Decode({0x81, 0x02}, frames, 256) || frames.size() != 1 || frames[0] != 1) {
+        std::cerr << "Malformed prefix was accepted" << std::endl;
+        return 1;
+    }
+
+    std::cout << "Framing OK" << std::endl;
+    return 0;
+}
@@ -0,0 +1,99 @@
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include "hash_ring.h"
+
+static Backend Make(const std::string& name) {
+    Backend backend;
+    if (!ParseBackend(name, backend)) {
+        std::cerr << "Cannot parse " << name << std::endl;
+        std::exit(1);
+    }
+    return backend;
+}
+
+int main() {
+    Backend parsed;
+    if (!ParseBackend("[::1]:4434", parsed) || parsed.host != "::1" || parsed.port != 4434 ||
+        !ParseBackend("10.0.0.7:4433", parsed) || parsed.host != "10.0.0.7" ||
+        ParseBackend("10.0.0.7", parsed) || ParseBackend(":4433", parsed) || ParseBackend("host:70000", parsed)) {
+        std::cerr << "Backend addresses are parsed wrongly" << std::endl;
+        return 1;
+    }
+
+    HashRing ring;
+    if (ring.route("robot-1")) {
+        std::cerr << "Empty ring routed a key" << std::endl;
+        return 1;
+    }
+    for (int i = 0; i < 4; ++i) {
+        ring.add(Make("10.0.0." + std::to_string(i + 1) + ":4433"));
+    }
+    if (ring.add(Make("10.0.0.1:4433")) || ring.size() != 4) {
+        std::cerr << "Duplicate backend was added" << std::endl;
+        return 1;
+    }
+
+    // Keys spread evenly enough over the backends
+    const int keys = 20000;
+    std::vector<std::string> before(keys);
+    std::map<std::string, int> load;
+    for (int k = 0; k < keys; ++k) {
+        before[k] = ring.route("robot-" + std::to_string(k))->name;
+        ++load[before[k]];
+    }
+    for (const auto& entry : load) {
+        if (entry.second < keys / 4 * 0.7 || entry.second > keys / 4 * 1.3) {
+            std::cerr << entry.first << " owns " << entry.second << " of " << keys << " keys" << std::endl;
+            return 1;
+        }
+    }
+
+    // A new backend only takes keys, about 1/5 of them; no key moves between old backends
+    ring.add(Make("10.0.0.5:4433"));
+    int moved = 0;
+    for (int k = 0; k < keys; ++k) {
+        const std::string& now = ring.route("robot-" + std::to_string(k))->name;
+        if (now != before[k]) {
+            if (now != "10.0.0.5:4433") {
+                std::cerr << "Key moved between existing backends" << std::endl;
+                return 1;
+            }
+            ++moved;
+        }
+    }
+    if (moved < keys / 5 * 0.7 || moved > keys / 5 * 1.3) {
+        std::cerr << "Adding a backend moved " << moved << " of " << keys << " keys" << std::endl;
+        return 1;
+    }
+
+    // Removing a backend only moves the keys it owned
+    ring.remove("10.0.0.2:4433");
+    for (int k = 0; k < keys; ++k) {
+        const std::string& now = ring.route("robot-" + std::to_string(k))->name;
+        if (before[k] != "10.0.0.2:4433" && now != before[k] && now != "10.0.0.5:4433") {
+            std::cerr << "Removing a backend moved a key it did not own" << std::endl;
+            return 1;
+        }
+        if (now == "10.0.0.2:4433") {
+            std::cerr << "Removed backend still owns a key" << std::endl;
+            return 1;
+        }
+    }
+
+    // Pool snapshots are immutable; a change shows up in the next snapshot
+    BackendPool pool;
+    pool.add(Make("127.0.0.1:4433"));
+    std::shared_ptr<const HashRing> snapshot = pool.ring();
+    pool.add(Make("127.0.0.1:4434"));
+    if (snapshot->size() != 1 || pool.ring()->size() != 2 || pool.add(Make("127.0.0.1:4434")) ||
+        !pool.remove("127.0.0.1:4433") || pool.remove("127.0.0.1:4433") ||
+        pool.ring()->route("robot-1")->name != "127.0.0.1:4434") {
+        std::cerr << "Backend pool snapshots are wrong" << std::endl;
+        return 1;
+    }
+
+    std::cout << "Hash ring OK" << std::endl;
+    return 0;
+}
@@ -0,0 +1,66 @@
+#include <iostream>
+#include <cmath>
+#include <thread>
+#include <vector>
+#include "histogram.h"
+
+static bool Near(uint64_t actual, uint64_t expected) {
+    // Bucket width bounds the error to 1/64 of the value
+    return std::fabs(static_cast<double>(actual) - static_cast<double>(expected)) <=
+           static_cast<double>(expected) / 64.0 + 1.0;
+}
+
+int main() {
+    // Every bucket index must round-trip through its upper bound
+    for (uint64_t v = 0; v < LatencyHistogram::MaxValue; v = v < 4096 ? v + 1 : v + v / 100) {
+        size_t index = LatencyHistogram::bucketIndex(v);
+        if (index >= LatencyHistogram::BucketCount || LatencyHistogram::bucketUpperBound(index) < v ||
+            (index > 0 && LatencyHistogram::bucketUpperBound(index - 1) >= v)) {
+            std::cerr << "Value " << v << " maps to wrong bucket " << index << std::endl;
+            return 1;
+        }
+    }
+
+    // 1..100000 us from four threads: percentiles are known exactly
+    LatencyHistogram histogram;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&histogram, t]() {
+            for (uint64_t v = 1 + t; v <= 100000; v += 4) {
+                histogram.record(v);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    LatencySnapshot s = histogram.snapshot();
+    if (s.count != 100000 || s.max != 100000 || !Near(s.p50, 50000) || !Near(s.p90, 90000) ||
+        !Near(s.p99, 99000) || !Near(s.p999, 99900)) {
+        std::cerr << "Unexpected percentiles: count " << s.count << " p50 " << s.p50 << " p90 " << s.p90
+                  << " p99 " << s.p99 << " p99.9 " << s.p999 << " max " << s.max << std::endl;
+        return 1;
+    }
+
+    // Merging adds counts; draining starts a new interval
+    LatencyHistogram other;
+    other.record(1000000);
+    histogram.merge(other);
+    LatencySnapshot merged = histogram.snapshotAndReset();
+    LatencySnapshot empty = histogram.snapshot();
+    if (merged.count != 100001 || merged.max != 1000000 || empty.count != 0 || empty.max != 0) {
+        std::cerr << "Merge/reset failed: merged count " << merged.count << " max " << merged.max
+                  << ", after reset " << empty.count << std::endl;
+        return 1;
+    }
+
+    // Values past the range are clamped, not dropped
+    histogram.record(~0ull);
+    if (histogram.snapshot().count != 1) {
+        std::cerr << "Out-of-range value lost" << std::endl;
+        return 1;
+    }
+
+    std::cout << "Latency histogram OK" << std::endl;
+    return 0;
+}
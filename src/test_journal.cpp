@@ -0,0 +1,118 @@
+#include <iostream>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+#include "journal.h"
+
+// Replays every segment of a journal in order
+static size_t ReplayAll(const std::string& dir, std::vector<uint32_t>& seen, bool& torn) {
+    size_t total = 0;
+    torn = false;
+    for (int index = 0;; ++index) {
+        char name[32];
+        snprintf(name, sizeof(name), "-%06d.journal", index);
+        std::string path = dir + "/commands" + name;
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0) {
+            break;
+        }
+        bool segmentTorn = false;
+        total += CommandJournal::replay(path, [&](uint64_t, const uint8_t* data, size_t length) {
+            uint32_t value;
+            if (length == sizeof(value)) {
+                memcpy(&value, data, sizeof(value));
+                seen.push_back(value);
+            }
+        }, &segmentTorn);
+        torn = torn || segmentTorn;
+    }
+    return total;
+}
+
+int main() {
+    char pattern[] = "/tmp/test_journal_XXXXXX";
+    const char* dir = mkdtemp(pattern);
+    if (!dir) {
+        std::cerr << "Failed to create temporary directory" << std::endl;
+        return 1;
+    }
+
+    const int threads = 4;
+    const int perThread = 2000;
+
+    // Small segments so the run rotates many times
+    CommandJournal journal;
+    if (!journal.open(dir, "commands", 4096, std::chrono::milliseconds(1))) {
+        std::cerr << "Failed to open journal" << std::endl;
+        return 1;
+    }
+    std::vector<std::thread> writers;
+    for (int t = 0; t < threads; ++t) {
+        writers.emplace_back([&journal, t]() {
+            for (int i = 0; i < perThread; ++i) {
+                uint32_t value = static_cast<uint32_t>(t * perThread + i);
+                journal.append(reinterpret_cast<const uint8_t*>(&value), sizeof(value));
+            }
+        });
+    }
+    for (auto& writer : writers) {
+        writer.join();
+    }
+    journal.close();
+
+    if (journal.recordCount() != static_cast<uint64_t>(threads * perThread) || journal.failedCount() != 0) {
+        std::cerr << "Journal accepted " << journal.recordCount() << " records, failed "
+                  << journal.failedCount() << std::endl;
+        return 1;
+    }
+
+    std::vector<uint32_t> seen;
+    bool torn = false;
+    size_t replayed = ReplayAll(dir, seen, torn);
+    std::vector<bool> found(threads * perThread, false);
+    for (uint32_t value : seen) {
+        if (value < found.size()) {
+            found[value] = true;
+        }
+    }
+    for (size_t i = 0; i < found.size(); ++i) {
+        if (!found[i]) {
+            std::cerr << "Record " << i << " missing after replay" << std::endl;
+            return 1;
+        }
+    }
+    if (replayed != found.size() || torn) {
+        std::cerr << "Replayed " << replayed << " records (torn: " << torn << ")" << std::endl;
+        return 1;
+    }
+
+    // Flip a payload byte in the first segment; replay must stop at that record
+    std::string first = std::string(dir) + "/commands-000000.journal";
+    int fd = ::open(first.c_str(), O_RDWR);
+    size_t offset = sizeof(Journal::SegmentHeader) + Journal::RecordSize(sizeof(uint32_t)) + sizeof(Journal::RecordHeader);
+    uint8_t byte = 0;
+    if (fd < 0 || pread(fd, &byte, 1, offset) != 1) {
+        std::cerr << "Failed to read back " << first << std::endl;
+        return 1;
+    }
+    byte ^= 0xFF;
+    if (pwrite(fd, &byte, 1, offset) != 1) {
+        std::cerr << "Failed to corrupt " << first << std::endl;
+        return 1;
+    }
+    ::close(fd);
+
+    size_t intact = CommandJournal::replay(first, [](uint64_t, const uint8_t*, size_t) {}, &torn);
+    if (intact != 1 || !torn) {
+        std::cerr << "Corrupt record not detected (intact: " << intact << ", torn: " << torn << ")" << std::endl;
+        return 1;
+    }
+
+    std::string cleanup = std::string("rm -rf ") + dir;
+    if (system(cleanup.c_str()) != 0) {
+        std::cerr << "Failed to remove " << dir << std::endl;
+    }
+    std::cout << "Command journal OK" << std::endl;
+    return 0;
+}
@@ -0,0 +1,102 @@
+#include <iostream>
+#include <atomic>
+#include <string>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "metrics.h"
+
+// Sends one request and returns everything the exporter answers
+static std::string Request(int fd, const sockaddr* address, socklen_t length, const std::string& request) {
+    std::string response;
+    if (fd < 0 || connect(fd, address, length) != 0) {
+        return response;
+    }
+    send(fd, request.data(), request.size(), MSG_NOSIGNAL);
+    char buffer[4096];
+    ssize_t n;
+    while ((n = recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+        response.append(buffer, static_cast<size_t>(n));
+    }
+    close(fd);
+    return response;
+}
+
+static std::string Get(uint16_t port, const std::string& request) {
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    return Request(socket(AF_INET, SOCK_STREAM, 0), reinterpret_cast<const sockaddr*>(&addr), sizeof(addr), request);
+}
+
+static std::string GetUnix(const std::string& path) {
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    path.copy(addr.sun_path, sizeof(addr.sun_path) - 1);
+    return Request(socket(AF_UNIX, SOCK_STREAM, 0), reinterpret_cast<const sockaddr*>(&addr), sizeof(addr),
+                   "GET /metrics HTTP/1.1\r\nHost: localhost\r\n\r\n");
+}
+
+int main() {
+    // Text format: families with HELP and TYPE, labels, integers without exponents
+    MetricsWriter writer;
+    writer.counter("requests_total", "Requests", 12345678901.0);
+    writer.family("rtt_seconds", "gauge", "RTT");
+    writer.sample("rtt_seconds", 0.0125, "connection=\"3\"");
+    LatencySnapshot latency;
+    latency.count = 4;
+    latency.p50 = 100;
+    latency.p99 = 2500;
+    latency.max = 3000;
+    latency.mean = 250.0;
+    writer.summary("latency_seconds", "Latency", latency);
+    const std::string expected =
+        "# HELP requests_total Requests\n# TYPE requests_total counter\nrequests_total 12345678901\n"
+        "# HELP rtt_seconds RTT\n# TYPE rtt_seconds gauge\nrtt_seconds{connection=\"3\"} 0.0125\n"
+        "# HELP latency_seconds Latency\n# TYPE latency_seconds summary\n"
+        "latency_seconds{quantile=\"0.5\"} 0.0001\nlatency_seconds{quantile=\"0.9\"} 0\n"
+        "latency_seconds{quantile=\"0.99\"} 0.0025\nlatency_seconds{quantile=\"0.999\"} 0\n"
+        "latency_seconds{quantile=\"1\"} 0.003\nlatency_seconds_sum 0.001\nlatency_seconds_count 4\n";
+    if (writer.text() != expected) {
+        std::cerr << "Unexpected exposition text:\n" << writer.text() << std::endl;
+        return 1;
+    }
+
+    // Every scrape runs the collector on the exporter thread
+    std::atomic<uint64_t> counter{41};
+    MetricsExporter exporter([&counter](MetricsWriter& w) {
+        w.counter("teleop_test_total", "Test counter", static_cast<double>(++counter));
+    });
+    const std::string path = "/tmp/teleop_test_metrics_" + std::to_string(getpid()) + ".sock";
+    if (!exporter.listenTcp(0) || !exporter.listenUnix(path) || !exporter.start()) {
+        std::cerr << "Failed to start the exporter" << std::endl;
+        return 1;
+    }
+    std::string tcp = Get(exporter.port(), "GET /metrics HTTP/1.1\r\nHost: localhost\r\n\r\n");
+    std::string local = GetUnix(path);
+    std::string post = Get(exporter.port(), "POST /metrics HTTP/1.1\r\nContent-Length: 0\r\n\r\n");
+    if (tcp.compare(0, 15, "HTTP/1.1 200 OK") != 0 || tcp.find("\r\n\r\n# HELP teleop_test_total") == std::string::npos ||
+        tcp.find("teleop_test_total 42\n") == std::string::npos) {
+        std::cerr << "Unexpected TCP response:\n" << tcp << std::endl;
+        return 1;
+    }
+    if (local.find("teleop_test_total 43\n") == std::string::npos) {
+        std::cerr << "Unexpected Unix socket response:\n" << local << std::endl;
+        return 1;
+    }
+    if (post.compare(0, 12, "HTTP/1.1 405") != 0 || exporter.scrapeCount() != 2) {
+        std::cerr << "Non-GET request was not refused" << std::endl;
+        return 1;
+    }
+    exporter.stop();
+    if (access(path.c_str(), F_OK) == 0) {
+        std::cerr << "Unix socket left behind" << std::endl;
+        return 1;
+    }
+
+    std::cout << "Metrics OK" << std::endl;
+    return 0;
+}
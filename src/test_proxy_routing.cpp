@@ -0,0 +1,127 @@
+#include <iostream>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "server.h"
+#include "client.h"
+#include "proxy.h"
+
+// Three servers on local ports behind one proxy. Clients for six robots
+// authenticate through the proxy and send commands; every robot's commands
+// must reach the server its robot_id hashes to, and no other, and every
+// server must pass the proxy's health probes.
+// Usage: test_proxy_routing [commands_per_client]
+
+static bool WaitFor(const std::function<bool()>& done, std::chrono::seconds timeout) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (!done()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    const uint64_t commands = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100;
+    const uint16_t proxyPort = 4930;
+    const int robots = 6;
+
+    std::vector<std::unique_ptr<QuicServer>> servers;
+    HashRing expected;
+    QuicProxy proxy;
+    for (uint16_t port = 4931; port <= 4933; ++port) {
+        ServerOptions options;
+        options.listen = {{"127.0.0.1", port}};
+        options.journalDirectory.clear();
+        servers.emplace_back(new QuicServer(options));
+        servers.back()->SetVerbose(false);
+        if (!servers.back()->Initialize() || !servers.back()->Start()) {
+            return 1;
+        }
+        Backend backend;
+        ParseBackend("127.0.0.1:" + std::to_string(port), backend);
+        expected.add(backend);
+        proxy.AddBackend(backend);
+    }
+    if (!proxy.Initialize() || !proxy.Start(proxyPort)) {
+        return 1;
+    }
+
+    std::vector<std::unique_ptr<QuicClient>> clients;
+    for (int r = 0; r < robots; ++r) {
+        clients.emplace_back(new QuicClient());
+        QuicClient& client = *clients.back();
+        if (!client.Initialize() || !client.Connect("127.0.0.1", proxyPort) ||
+            !WaitFor([&client]() { return client.IsConnected(); }, std::chrono::seconds(10)) ||
+            !client.Authenticate("operator-" + std::to_string(r), "robot-" + std::to_string(r)) ||
+            !WaitFor([&client]() { return client.IsAuthenticated(); }, std::chrono::seconds(10))) {
+            std::cerr << "Client for robot-" << r << " could not authenticate through the proxy" << std::endl;
+            return 1;
+        }
+    }
+
+    for (uint64_t i = 0; i < commands; ) {
+        bool sent = true;
+        for (auto& client : clients) {
+            sent = client->SendControlCommand(0.5f, 0.0f) && sent;
+        }
+        if (!sent) {
+            std::cerr << "Command could not be sent" << std::endl;
+            return 1;
+        }
+        ++i;
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+
+    std::map<std::string, uint64_t> owned;
+    for (int r = 0; r < robots; ++r) {
+        owned[expected.route("robot-" + std::to_string(r))->name] += commands;
+    }
+    auto received = [&]() {
+        uint64_t total = 0;
+        for (auto& server : servers) {
+            total += server->GetCommandsReceived();
+        }
+        return total;
+    };
+    if (!WaitFor([&]() { return received() >= robots * commands; }, std::chrono::seconds(10))) {
+        std::cerr << "Only " << received() << " of " << robots * commands << " commands arrived" << std::endl;
+        return 1;
+    }
+    for (size_t s = 0; s < servers.size(); ++s) {
+        const std::string name = "127.0.0.1:" + std::to_string(4931 + s);
+        if (servers[s]->GetCommandsReceived() != owned[name]) {
+            std::cerr << name << " received " << servers[s]->GetCommandsReceived() << " commands, expected "
+                      << owned[name] << std::endl;
+            return 1;
+        }
+    }
+
+    // Every backend answers its health probes and stays available
+    auto allAvailable = [&proxy]() {
+        std::vector<BackendStatus> health = proxy.GetBackendStatus();
+        for (const BackendStatus& status : health) {
+            if (!status.probes || status.failedProbes || !status.available || !status.probeRttUs) {
+                return false;
+            }
+        }
+        return health.size() == 3;
+    };
+    if (!WaitFor(allAvailable, std::chrono::seconds(10))) {
+        for (const BackendStatus& status : proxy.GetBackendStatus()) {
+            std::cerr << status.name << ": " << status.probes << " probes, " << status.failedProbes
+                      << " failed, available " << status.available << std::endl;
+        }
+        return 1;
+    }
+
+    clients.clear();
+    std::cout << "Proxy routing OK" << std::endl;
+    return 0;
+}
@@ -0,0 +1,79 @@
+#include <iostream>
+#include <vector>
+#include "relay.h"
+
+struct Stream {};
+
+int main() {
+    RelayPool<Stream> pool(4, 64);
+    Stream source;
+
+    // In place: the prefix is rebuilt, the payload is not copied
+    uint8_t payload[300];
+    for (size_t i = 0; i < sizeof(payload); ++i) {
+        payload[i] = static_cast<uint8_t>(i);
+    }
+    RelaySend<Stream>* relay = pool.acquire();
+    relay->From = &source;
+    QUIC_BUFFER* frame = relay->frame(payload, sizeof(payload));
+    if (frame[0].Length != 2 || frame[0].Buffer[0] != (0x80 | (300 & 0x7f)) || frame[0].Buffer[1] != (300 >> 7) ||
+        frame[1].Buffer != payload || frame[1].Length != sizeof(payload)) {
+        std::cerr << "In-place frame does not point at the received payload" << std::endl;
+        return 1;
+    }
+
+    // Gathered frames are copied once and decode back to the same bytes
+    std::vector<uint8_t> wire;
+    frame = relay->frameCopy(payload, sizeof(payload));
+    if (frame[1].Buffer == payload) {
+        std::cerr << "Copied frame still points at the received payload" << std::endl;
+        return 1;
+    }
+    for (int i = 0; i < 2; ++i) {
+        wire.insert(wire.end(), frame[i].Buffer, frame[i].Buffer + frame[i].Length);
+    }
+    FrameDecoder decoder;
+    size_t frames = 0;
+    decoder.feed(wire.data(), wire.size(), [&](const uint8_t* data, size_t length) {
+        frames += length == sizeof(payload) && memcmp(data, payload, length) == 0;
+    });
+    if (frames != 1) {
+        std::cerr << "Relayed frame does not decode to the original message" << std::endl;
+        return 1;
+    }
+
+    // A datagram is the payload alone
+    QUIC_BUFFER* datagram = relay->copy(payload, 10);
+    if (datagram->Length != 10 || memcmp(datagram->Buffer, payload, 10) != 0) {
+        std::cerr << "Datagram copy is wrong" << std::endl;
+        return 1;
+    }
+
+    // Slots in flight are not handed out twice, and only slots are owned
+    std::vector<RelaySend<Stream>*> held{relay};
+    while (RelaySend<Stream>* slot = pool.acquire()) {
+        if (slot->From) {
+            std::cerr << "Acquired slot still refers to a source" << std::endl;
+            return 1;
+        }
+        held.push_back(slot);
+    }
+    if (held.size() != pool.capacity() || pool.exhaustedCount() != 1) {
+        std::cerr << "Pool handed out " << held.size() << " of " << pool.capacity() << " slots" << std::endl;
+        return 1;
+    }
+    for (RelaySend<Stream>* slot : held) {
+        if (!pool.owns(slot)) {
+            std::cerr << "Pool does not own its slot" << std::endl;
+            return 1;
+        }
+        pool.release(slot);
+    }
+    if (pool.owns(&source) || pool.owns(payload) || pool.owns(nullptr)) {
+        std::cerr << "Pool claims a foreign pointer" << std::endl;
+        return 1;
+    }
+
+    std::cout << "Relay OK" << std::endl;
+    return 0;
+}
@@ -0,0 +1,82 @@
+#include <iostream>
+#include "replay_window.h"
+
+using Window = ReplayWindow<4>;
+
+static bool Expect(Window& window, uint32_t sequence, Window::Result expected) {
+    Window::Result result = window.check(sequence);
+    if (result != expected) {
+        std::cerr << "Sequence " << sequence << ": got " << static_cast<int>(result)
+                  << ", expected " << static_cast<int>(expected) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int main() {
+    Window window;
+    bool ok = true;
+
+    // In-order, a gap, a late arrival filling it, and a replay of each kind
+    ok = ok && Expect(window, 1, Window::Result::New);
+    ok = ok && Expect(window, 2, Window::Result::New);
+    ok = ok && Expect(window, 5, Window::Result::New);
+    ok = ok && Expect(window, 4, Window::Result::Reordered);
+    ok = ok && Expect(window, 4, Window::Result::Duplicate);
+    ok = ok && Expect(window, 5, Window::Result::Duplicate);
+    ok = ok && Expect(window, 2, Window::Result::Duplicate);
+    if (!ok || window.gapCount() != 2 || window.reorderedCount() != 1 || window.duplicateCount() != 3) {
+        std::cerr << "Counters: gaps " << window.gapCount() << " reordered " << window.reorderedCount()
+                  << " duplicates " << window.duplicateCount() << std::endl;
+        return 1;
+    }
+
+    // Everything within Size behind the highest is still tracked, older is stale
+    ok = ok && Expect(window, 5 + Window::Size, Window::Result::New);
+    ok = ok && Expect(window, 5, Window::Result::Duplicate);
+    ok = ok && Expect(window, 6, Window::Result::Reordered);
+    ok = ok && Expect(window, 4, Window::Result::Stale);
+    // A jump far past the window forgets everything before it
+    ok = ok && Expect(window, 100000, Window::Result::New);
+    ok = ok && Expect(window, 100000 - 1, Window::Result::Reordered);
+    ok = ok && Expect(window, 5 + Window::Size, Window::Result::Stale);
+    if (!ok || window.staleCount() != 2) {
+        return 1;
+    }
+
+    // Wrap-around of the 32-bit counter
+    Window wrap;
+    ok = ok && Expect(wrap, 0xFFFFFFF0u, Window::Result::New);
+    ok = ok && Expect(wrap, 0xFFFFFFFFu, Window::Result::New);
+    ok = ok && Expect(wrap, 3, Window::Result::New);
+    ok = ok && Expect(wrap, 0, Window::Result::Reordered);
+    ok = ok && Expect(wrap, 0xFFFFFFFFu, Window::Result::Duplicate);
+    ok = ok && Expect(wrap, 0xFFFFFFF0u, Window::Result::Duplicate);
+    ok = ok && Expect(wrap, 0xFFFFFFF1u, Window::Result::Reordered);
+    if (!ok) {
+        return 1;
+    }
+
+    // Exhaustive: a shuffled-in-blocks stream is accepted exactly once per number
+    Window shuffled;
+    uint64_t accepted = 0;
+    for (uint32_t base = 0; base < 100000; base += 16) {
+        for (uint32_t i = 0; i < 16; ++i) {
+            uint32_t sequence = base + ((i * 7) & 15);
+            Window::Result first = shuffled.check(sequence);
+            accepted += first == Window::Result::New || first == Window::Result::Reordered;
+            if (shuffled.check(sequence) != Window::Result::Duplicate) {
+                std::cerr << "Replay of " << sequence << " accepted" << std::endl;
+                return 1;
+            }
+        }
+    }
+    if (accepted != 100000 || shuffled.gapCount() != shuffled.reorderedCount()) {
+        std::cerr << "Accepted " << accepted << ", gaps " << shuffled.gapCount()
+                  << ", reordered " << shuffled.reorderedCount() << std::endl;
+        return 1;
+    }
+
+    std::cout << "Replay window OK" << std::endl;
+    return 0;
+}
@@ -0,0 +1,95 @@
+#include <iostream>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include "teleop_generated.h"
+#include "send_buffer.h"
+#include "envelope.h"
+
+// Count every heap allocation made by the process
+static std::atomic<size_t> allocations{0};
+
+void* operator new(size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+// Encodes the same command shape the client sends, plus the optional fields
+static void EncodeCommand(SendBuffer* buffer, uint32_t sequence) {
+    flatbuffers::FlatBufferBuilder& builder = buffer->Builder;
+    auto target = Teleop::CreateVector2D(builder, 1.0f, 2.0f);
+    auto client_id = builder.CreateString("operator-1");
+    auto command = Teleop::CreateControlCommand(
+        builder,
+        Teleop::CommandType_MOVE,
+        0.5f,
+        0.1f,
+        target,
+        123456,
+        sequence,
+        client_id
+    );
+    FinishEnvelope(builder, command);
+    buffer->seal();
+}
+
+int main() {
+    const int warmup = 256;
+    const int iterations = 100000;
+    SendBufferPool pool(8);
+
+    // Warm-up: grow every slot to its steady-state size
+    for (int i = 0; i < warmup; ++i) {
+        SendBuffer* buffer = pool.acquire();
+        EncodeCommand(buffer, i);
+        pool.release(buffer);
+    }
+
+    size_t before = allocations.load();
+    for (int i = 0; i < iterations; ++i) {
+        SendBuffer* buffer = pool.acquire();
+        if (!buffer) {
+            std::cerr << "Pool exhausted" << std::endl;
+            return 1;
+        }
+        EncodeCommand(buffer, warmup + i);
+
+        const Teleop::Envelope* envelope = OpenEnvelope(buffer->Quic.Buffer, buffer->Quic.Length);
+        if (!envelope || !envelope->payload_as_ControlCommand() ||
+            envelope->payload_as_ControlCommand()->sequence_number() != static_cast<uint32_t>(warmup + i)) {
+            std::cerr << "Invalid buffer!" << std::endl;
+            return 1;
+        }
+        pool.release(buffer);
+    }
+    size_t after = allocations.load();
+
+    std::cout << "Allocations per command after warm-up: "
+              << static_cast<double>(after - before) / iterations << std::endl;
+    if (after != before) {
+        std::cerr << "Expected zero allocations, saw " << (after - before) << std::endl;
+        return 1;
+    }
+
+    // Buffers in flight must not be handed out twice
+    std::vector<SendBuffer*> held;
+    while (SendBuffer* buffer = pool.acquire()) {
+        held.push_back(buffer);
+    }
+    if (held.size() != pool.capacity() || pool.exhaustedCount() != 1) {
+        std::cerr << "Pool handed out " << held.size() << " of " << pool.capacity() << " buffers" << std::endl;
+        return 1;
+    }
+    for (SendBuffer* buffer : held) {
+        pool.release(buffer);
+    }
+
+    std::cout << "Send buffer pool OK" << std::endl;
+    return 0;
+}
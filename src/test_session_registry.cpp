@@ -0,0 +1,127 @@
+#include <iostream>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include "session_registry.h"
+
+struct TestSession {
+    const void* Connection;
+    std::string ClientId;
+    std::string RobotId;
+    uint64_t Commands{0};
+
+    explicit TestSession(const void* connection) : Connection(connection) {}
+};
+
+static const void* Handle(uintptr_t n) { return reinterpret_cast<const void*>(n * 64); }
+
+int main() {
+    SessionRegistry<TestSession> registry(4);
+
+    // Lookups by every key reach the same session
+    TestSession* a = registry.create(Handle(1));
+    registry.bindClient(a, "operator-1");
+    registry.bindRobot(a, "robot-1");
+    bool found = registry.visitConnection(Handle(1), [a](TestSession& s) { s.Commands = &s == a ? 1 : 0; }) &&
+                 registry.visitClient("operator-1", [](TestSession& s) { ++s.Commands; }) &&
+                 registry.visitRobot(std::string_view("robot-1xyz", 7), [](TestSession& s) { ++s.Commands; });
+    if (!found || a->Commands != 3 || registry.size() != 1) {
+        std::cerr << "Lookup by connection, client or robot failed" << std::endl;
+        return 1;
+    }
+
+    // Rebinding moves the key; a newer session takes over a robot id and
+    // keeps it when the older one goes away
+    registry.bindRobot(a, "robot-2");
+    TestSession* b = registry.create(Handle(2));
+    registry.bindRobot(b, "robot-2");
+    registry.destroy(a);
+    TestSession* owner = nullptr;
+    registry.visitRobot("robot-2", [&owner](TestSession& s) { owner = &s; });
+    if (owner != b || registry.visitRobot("robot-1", [](TestSession&) {}) ||
+        registry.visitClient("operator-1", [](TestSession&) {}) || registry.size() != 1) {
+        std::cerr << "Rebind or takeover failed" << std::endl;
+        return 1;
+    }
+
+    // Ids past the small-string buffer live on the heap; after a takeover
+    // the key must be the new owner's, whether the old session goes away
+    // or moves on to another id
+    const std::string longClient(64, 'c');
+    const std::string longRobot(64, 'r');
+    TestSession* first = registry.create(Handle(3));
+    registry.bindClient(first, longClient);
+    registry.bindRobot(first, longRobot);
+    TestSession* second = registry.create(Handle(4));
+    registry.bindClient(second, longClient);
+    registry.bindRobot(second, longRobot);
+    registry.bindClient(first, std::string(64, 'x'));
+    registry.destroy(first);
+    owner = nullptr;
+    TestSession* clientOwner = nullptr;
+    registry.visitRobot(longRobot, [&owner](TestSession& s) { owner = &s; });
+    registry.visitClient(longClient, [&clientOwner](TestSession& s) { clientOwner = &s; });
+    if (owner != second || clientOwner != second) {
+        std::cerr << "Taken-over id lost its session" << std::endl;
+        return 1;
+    }
+    registry.destroy(second);
+
+    // The pool is bounded and recycles slots at stable addresses
+    std::vector<TestSession*> sessions;
+    for (uintptr_t i = 10; TestSession* s = registry.create(Handle(i)); ++i) {
+        sessions.push_back(s);
+    }
+    if (sessions.size() != 3) {
+        std::cerr << "Pool handed out " << sessions.size() << " sessions, expected 3" << std::endl;
+        return 1;
+    }
+    registry.destroy(sessions.back());
+    if (registry.create(Handle(99)) != sessions.back()) {
+        std::cerr << "Freed slot was not reused" << std::endl;
+        return 1;
+    }
+
+    // Sessions come and go on several threads while others look them up
+    SessionRegistry<TestSession> shared(256);
+    std::atomic<bool> running{true};
+    std::atomic<uint64_t> hits{0};
+    std::vector<std::thread> owners;
+    for (int t = 0; t < 4; ++t) {
+        owners.emplace_back([&shared, t]() {
+            for (int round = 0; round < 2000; ++round) {
+                std::vector<TestSession*> mine;
+                for (int i = 0; i < 32; ++i) {
+                    TestSession* s = shared.create(Handle(1000 + t * 100 + i));
+                    shared.bindRobot(s, "robot-" + std::to_string(t * 100 + i));
+                    mine.push_back(s);
+                }
+                for (TestSession* s : mine) {
+                    shared.destroy(s);
+                }
+            }
+        });
+    }
+    std::thread reader([&]() {
+        while (running.load(std::memory_order_relaxed)) {
+            for (int i = 0; i < 432; ++i) {
+                shared.visitRobot("robot-" + std::to_string(i), [&hits](TestSession& s) {
+                    hits.fetch_add(s.Connection != nullptr, std::memory_order_relaxed);
+                });
+            }
+        }
+    });
+    for (auto& thread : owners) {
+        thread.join();
+    }
+    running = false;
+    reader.join();
+    if (shared.size() != 0) {
+        std::cerr << shared.size() << " sessions left registered" << std::endl;
+        return 1;
+    }
+
+    std::cout << "Session registry OK (" << hits.load() << " concurrent hits)" << std::endl;
+    return 0;
+}
@@ -0,0 +1,159 @@
+#include <iostream>
+#include <string>
+#include <openssl/hmac.h>
+#include "signed_token.h"
+
+using Result = TokenKeyring::Result;
+
+static Result Verify(const TokenKeyring& keys, const std::string& text, uint64_t nowSec, SignedToken& token) {
+    return keys.verify(text.data(), text.size(), nowSec, token);
+}
+
+int main() {
+    const uint8_t first[32] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17};
+    const uint8_t second[20] = {42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 7};
+    const uint64_t now = 1700000000;
+
+    TokenKeyring keys;
+    if (!keys.sign("operator-1", "robot-1", now + 60).empty() || keys.add(1, first, TokenKey::MinSize - 1, true) ||
+        !keys.add(1, first, sizeof(first), true) || keys.add(1, second, sizeof(second), false)) {
+        std::cerr << "Key was accepted wrongly" << std::endl;
+        return 1;
+    }
+
+    // A token carries its claims and is good until it expires
+    std::string text = keys.sign("operator-1", "robot-1", now + 60);
+    SignedToken token;
+    if (Verify(keys, text, now, token) != Result::Valid || token.clientId() != "operator-1" ||
+        token.robotId() != "robot-1" || token.expiresSec != now + 60 || token.keyId != 1 ||
+        Verify(keys, text, now + 60, token) != Result::Expired) {
+        std::cerr << "Token claims were not verified" << std::endl;
+        return 1;
+    }
+
+    // The MAC is standard HMAC-SHA256, also for keys longer than a block
+    uint8_t expected[SignedToken::MacSize];
+    unsigned int expectedLength = 0;
+    HMAC(EVP_sha256(), first, sizeof(first), token.bytes, token.signedSize(), expected, &expectedLength);
+    uint8_t longKey[100];
+    for (size_t i = 0; i < sizeof(longKey); ++i) {
+        longKey[i] = static_cast<uint8_t>(i * 7);
+    }
+    TokenKey hashed(9, longKey, sizeof(longKey));
+    uint8_t ours[SignedToken::MacSize];
+    uint8_t theirs[SignedToken::MacSize];
+    HMAC(EVP_sha256(), longKey, sizeof(longKey), token.bytes, token.signedSize(), theirs, &expectedLength);
+    if (memcmp(expected, token.mac(), sizeof(expected)) != 0 || !hashed.mac(token.bytes, token.signedSize(), ours) ||
+        memcmp(ours, theirs, sizeof(ours)) != 0) {
+        std::cerr << "MAC differs from HMAC-SHA256" << std::endl;
+        return 1;
+    }
+
+    // Changing any digit breaks it
+    for (size_t i = 0; i < text.size(); ++i) {
+        std::string tampered = text;
+        tampered[i] = tampered[i] == 'A' ? 'B' : 'A';
+        if (Verify(keys, tampered, now, token) == Result::Valid) {
+            std::cerr << "Token tampered at digit " << i << " still verifies" << std::endl;
+            return 1;
+        }
+    }
+    if (Verify(keys, text + "A", now, token) != Result::Malformed ||
+        Verify(keys, text.substr(0, text.size() - 1), now, token) == Result::Valid ||
+        Verify(keys, "", now, token) != Result::Malformed ||
+        Verify(keys, std::string(SignedToken::MaxTextSize + 4, 'A'), now, token) != Result::Malformed) {
+        std::cerr << "Malformed token was accepted" << std::endl;
+        return 1;
+    }
+
+    // Any length of ids round-trips, and an id too long for the format is refused
+    for (size_t length = 0; length <= SignedToken::MaxIdSize; length += 1 + length / 8) {
+        std::string client(length, 'c');
+        std::string robot(SignedToken::MaxIdSize - length, 'r');
+        std::string signed_ = keys.sign(client, robot, now + 1);
+        if (Verify(keys, signed_, now, token) != Result::Valid || token.clientId() != client || token.robotId() != robot) {
+            std::cerr << "Token with a " << length << "-byte client_id did not round-trip" << std::endl;
+            return 1;
+        }
+    }
+    if (!keys.sign(std::string(SignedToken::MaxIdSize + 1, 'c'), "robot-1", now + 60).empty()) {
+        std::cerr << "Oversized client_id was signed" << std::endl;
+        return 1;
+    }
+
+    // A sibling with the same key honours the token; one with another key does not
+    TokenKeyring sibling;
+    TokenKeyring stranger;
+    sibling.add(1, first, sizeof(first), true);
+    stranger.add(1, second, sizeof(second), true);
+    if (Verify(sibling, text, now, token) != Result::Valid ||
+        Verify(stranger, text, now, token) != Result::BadSignature) {
+        std::cerr << "Token was judged wrongly by another proxy" << std::endl;
+        return 1;
+    }
+
+    // Rotation: learn the new key, sign with it, then retire the old one
+    if (!keys.add(2, second, sizeof(second), false) || Verify(keys, keys.sign("operator-1", "robot-1", now + 60), now,
+                                                              token) != Result::Valid || token.keyId != 1) {
+        std::cerr << "New key took over before it was used" << std::endl;
+        return 1;
+    }
+    if (!keys.use(2) || keys.use(3) || keys.retire(2)) {
+        std::cerr << "Signing key was not switched" << std::endl;
+        return 1;
+    }
+    std::string rotated = keys.sign("operator-1", "robot-1", now + 60);
+    if (Verify(keys, rotated, now, token) != Result::Valid || token.keyId != 2 ||
+        Verify(keys, text, now, token) != Result::Valid || Verify(sibling, rotated, now, token) != Result::UnknownKey) {
+        std::cerr << "Tokens of both keys were not honoured during rotation" << std::endl;
+        return 1;
+    }
+    if (!keys.retire(1) || keys.size() != 1 || Verify(keys, text, now, token) != Result::UnknownKey ||
+        Verify(keys, rotated, now, token) != Result::Valid) {
+        std::cerr << "Retired key still verifies" << std::endl;
+        return 1;
+    }
+
+    // A connection's repeated token is not checked again, until the keys change
+    VerifiedToken last;
+    if (keys.verify(rotated.data(), rotated.size(), now, last) != Result::Valid || last.token.keyId != 2 ||
+        keys.verify(rotated.data(), rotated.size(), now + 60, last) != Result::Expired ||
+        keys.verify(text.data(), text.size(), now, last) != Result::UnknownKey || last.generation != 0) {
+        std::cerr << "Cached token was judged wrongly" << std::endl;
+        return 1;
+    }
+    keys.verify(rotated.data(), rotated.size(), now, last);
+    std::string forged = rotated;
+    forged.back() = forged.back() == 'A' ? 'B' : 'A';
+    if (keys.verify(forged.data(), forged.size(), now, last) == Result::Valid ||
+        keys.verify(rotated.data(), rotated.size(), now, last) != Result::Valid) {
+        std::cerr << "Token differing from the cached one was accepted" << std::endl;
+        return 1;
+    }
+    keys.add(3, first, sizeof(first), true);
+    keys.retire(2);
+    if (keys.verify(rotated.data(), rotated.size(), now, last) != Result::UnknownKey) {
+        std::cerr << "Cached token outlived its key" << std::endl;
+        return 1;
+    }
+
+    // A revoked token is refused, also when cached, and forgotten once it has expired
+    std::string kept = keys.sign("operator-2", "robot-2", now + 120);
+    std::string dropped = keys.sign("operator-1", "robot-1", now + 60);
+    keys.verify(dropped.data(), dropped.size(), now, last);
+    if (!keys.revoke(dropped.data(), dropped.size(), now) || keys.revoke(dropped.data(), dropped.size(), now) ||
+        keys.revoke(forged.data(), forged.size(), now) || keys.revoked() != 1 ||
+        keys.verify(dropped.data(), dropped.size(), now, last) != Result::Revoked ||
+        Verify(keys, kept, now, token) != Result::Valid) {
+        std::cerr << "Revoked token was judged wrongly" << std::endl;
+        return 1;
+    }
+    if (!keys.revoke(kept.data(), kept.size(), now + 60) || keys.revoked() != 1 ||
+        Verify(keys, kept, now, token) != Result::Revoked) {
+        std::cerr << "Expired revocation was kept" << std::endl;
+        return 1;
+    }
+
+    std::cout << "Signed token OK" << std::endl;
+    return 0;
+}
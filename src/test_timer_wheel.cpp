@@ -0,0 +1,71 @@
+#include <iostream>
+#include <random>
+#include <vector>
+#include "timer_wheel.h"
+
+int main() {
+    // Random schedules, re-arms and cancels checked against a plain array of
+    // deadlines, with delays that reach every level of the wheel
+    const uint32_t timers = 512;
+    TimerWheel wheel(timers, 1000);
+    std::vector<uint64_t> deadline(timers, 0);  // 0 = not armed
+    std::mt19937_64 rng(7);
+    std::uniform_int_distribution<uint32_t> pick(0, timers - 1);
+    std::uniform_int_distribution<int> action(0, 9);
+    std::uniform_int_distribution<int> scale(0, 3);
+
+    uint64_t fired = 0;
+    for (int step = 0; step < 200000; ++step) {
+        int a = action(rng);
+        uint32_t id = pick(rng);
+        if (a < 6) {
+            uint64_t range = 1ull << (TimerWheel::SlotBits * (scale(rng) + 1));
+            uint64_t tick = wheel.now() + rng() % range;
+            wheel.schedule(id, tick);
+            deadline[id] = tick;
+        } else if (a < 7) {
+            wheel.cancel(id);
+            deadline[id] = 0;
+        } else {
+            uint64_t to = wheel.now() + rng() % 200;
+            bool ok = true;
+            wheel.advance(to, [&](uint32_t expired) {
+                // Fires on its tick, never early and never twice
+                ok = ok && deadline[expired] != 0 && deadline[expired] == wheel.now() - 1;
+                deadline[expired] = 0;
+                ++fired;
+            });
+            for (uint32_t i = 0; ok && i < timers; ++i) {
+                ok = deadline[i] == 0 || deadline[i] > to;
+            }
+            if (!ok) {
+                std::cerr << "Timer fired at the wrong tick (step " << step << ", now " << wheel.now() << ")" << std::endl;
+                return 1;
+            }
+        }
+    }
+    size_t armed = 0;
+    for (uint64_t d : deadline) {
+        armed += d != 0;
+    }
+    if (armed != wheel.armedCount() || fired == 0) {
+        std::cerr << "Armed count " << wheel.armedCount() << ", expected " << armed << std::endl;
+        return 1;
+    }
+
+    // A callback can re-arm the timer that fired; it runs again on a later tick
+    TimerWheel periodic(1);
+    periodic.schedule(0, 10);
+    uint64_t runs = 0;
+    periodic.advance(1000, [&](uint32_t id) {
+        ++runs;
+        periodic.schedule(id, periodic.now() + 9);
+    });
+    if (runs != 100) {
+        std::cerr << "Periodic timer ran " << runs << " times, expected 100" << std::endl;
+        return 1;
+    }
+
+    std::cout << "Timer wheel OK (" << fired << " timers fired)" << std::endl;
+    return 0;
+}
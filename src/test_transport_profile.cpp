@@ -0,0 +1,69 @@
+#include <iostream>
+#include <sstream>
+#include "transport_profile.h"
+
+int main() {
+    TransportProfiles profiles;
+    for (const char* name : {"default", "low-latency-control", "bulk-telemetry", "lossy-wireless"}) {
+        if (!profiles.find(name)) {
+            std::cerr << "Missing built-in profile " << name << std::endl;
+            return 1;
+        }
+    }
+
+    // The default profile is what the binaries set before profiles existed
+    QUIC_SETTINGS settings = {0};
+    profiles.find("default")->apply(settings);
+    if (!settings.IsSet.SendBufferingEnabled || !settings.SendBufferingEnabled ||
+        settings.KeepAliveIntervalMs != 1000 || settings.DisconnectTimeoutMs != 30000 ||
+        settings.CongestionControlAlgorithm != QUIC_CONGESTION_CONTROL_ALGORITHM_CUBIC) {
+        std::cerr << "Default profile does not match the previous settings" << std::endl;
+        return 1;
+    }
+
+    // A section for a built-in profile changes only the keys it lists; a new
+    // one starts from the defaults
+    std::istringstream file(
+        "# site overrides\n"
+        "[lossy-wireless]\n"
+        "  initial_rtt_ms = 80   # measured on the yard network\n"
+        "pacing = off\n"
+        "\n"
+        "[teleop-lab]\n"
+        "congestion_control=bbr\n"
+        "idle_timeout_ms = 60000\n");
+    std::string error;
+    if (!profiles.load(file, error)) {
+        std::cerr << "Load failed: " << error << std::endl;
+        return 1;
+    }
+    const TransportProfile* wireless = profiles.find("lossy-wireless");
+    const TransportProfile* lab = profiles.find("teleop-lab");
+    if (!wireless || wireless->initialRttMs != 80 || wireless->pacing ||
+        wireless->congestionControl != QUIC_CONGESTION_CONTROL_ALGORITHM_BBR || wireless->keepAliveIntervalMs != 500) {
+        std::cerr << "Override of a built-in profile failed" << std::endl;
+        return 1;
+    }
+    if (!lab || lab->name != "teleop-lab" || lab->congestionControl != QUIC_CONGESTION_CONTROL_ALGORITHM_BBR ||
+        lab->idleTimeoutMs != 60000 || lab->keepAliveIntervalMs != 1000) {
+        std::cerr << "New profile not loaded" << std::endl;
+        return 1;
+    }
+
+    // A bad line rejects the whole file
+    for (const char* bad : {"initial_rtt_ms = 10\n",
+                            "[default]\ninitial_rtt_ms = 10\npacing = maybe\n",
+                            "[default]\ncongestion_control = reno\n",
+                            "[default]\nkeep_alive_ms = 99999999999\n",
+                            "[default]\nunknown = 1\n",
+                            "[]\n"}) {
+        std::istringstream in(bad);
+        if (profiles.load(in, error) || profiles.find("default")->initialRttMs != 333) {
+            std::cerr << "Accepted invalid profile file: " << bad << std::endl;
+            return 1;
+        }
+    }
+
+    std::cout << "Transport profiles OK (" << profiles.names().size() << " profiles)" << std::endl;
+    return 0;
+}
@@ -0,0 +1,168 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Hierarchical timing wheel (Varghese and Lauck; the classic Linux timer
+// layout). Timers are identified by a dense index chosen by the caller, e.g.
+// a session slot, and live in a fixed array, so scheduling, re-arming and
+// cancelling are O(1) list operations with no allocation. Level 0 has one
+// slot per tick; each higher level covers 64 times the range of the one
+// below and is cascaded down as time reaches it, so a timer is moved at most
+// Levels - 1 times before it fires. Delays beyond the top level are clamped.
+//
+// Not thread-safe: one thread owns the wheel.
+class TimerWheel {
+public:
+    static constexpr unsigned SlotBits = 6;
+    static constexpr uint32_t Slots = 1u << SlotBits;
+    static constexpr unsigned Levels = 4;
+    static constexpr uint64_t MaxDelay = (1ull << (SlotBits * Levels)) - 1;
+
+private:
+    static constexpr uint32_t None = UINT32_MAX;
+    static constexpr uint32_t Firing = Levels * Slots;  // list being expired by advance()
+
+    struct Timer {
+        uint64_t expiry{0};
+        uint32_t next{None};
+        uint32_t prev{None};
+        uint32_t list{None};
+    };
+
+    std::vector<Timer> timers;
+    uint32_t heads[Levels * Slots + 1];
+    uint64_t current;   // next tick to be processed
+    size_t count{0};
+
+    void link(uint32_t id, uint32_t list) {
+        Timer& timer = timers[id];
+        timer.list = list;
+        timer.prev = None;
+        timer.next = heads[list];
+        if (timer.next != None) {
+            timers[timer.next].prev = id;
+        }
+        heads[list] = id;
+    }
+
+    void unlink(uint32_t id) {
+        Timer& timer = timers[id];
+        if (timer.prev != None) {
+            timers[timer.prev].next = timer.next;
+        } else {
+            heads[timer.list] = timer.next;
+        }
+        if (timer.next != None) {
+            timers[timer.next].prev = timer.prev;
+        }
+        timer.list = None;
+    }
+
+    // Puts a timer into the slot of the lowest level whose range covers it
+    void place(uint32_t id) {
+        uint64_t expiry = timers[id].expiry;
+        uint64_t delta = expiry - current;
+        unsigned level = 0;
+        while (level + 1 < Levels && delta >= (1ull << (SlotBits * (level + 1)))) {
+            ++level;
+        }
+        link(id, level * Slots + static_cast<uint32_t>((expiry >> (SlotBits * level)) & (Slots - 1)));
+    }
+
+    // Moves the timers of one higher-level slot down, now that it is due
+    void cascade(unsigned level, uint32_t slot) {
+        uint32_t list = level * Slots + slot;
+        uint32_t id = heads[list];
+        heads[list] = None;
+        while (id != None) {
+            uint32_t next = timers[id].next;
+            place(id);
+            id = next;
+        }
+    }
+
+public:
+    explicit TimerWheel(size_t capacity, uint64_t startTick = 0)
+        : timers(capacity), current(startTick) {
+        for (uint32_t& head : heads) {
+            head = None;
+        }
+    }
+
+    // Arms the timer to fire at the given tick, replacing any earlier arming.
+    // Ticks already processed fire on the next advance().
+    void schedule(uint32_t id, uint64_t tick) {
+        if (timers[id].list != None) {
+            unlink(id);
+        } else {
+            ++count;
+        }
+        if (tick < current) {
+            tick = current;
+        } else if (tick - current > MaxDelay) {
+            tick = current + MaxDelay;
+        }
+        timers[id].expiry = tick;
+        place(id);
+    }
+
+    void cancel(uint32_t id) {
+        if (timers[id].list != None) {
+            unlink(id);
+            --count;
+        }
+    }
+
+    bool armed(uint32_t id) const { return timers[id].list != None; }
+    uint64_t expiry(uint32_t id) const { return timers[id].expiry; }
+    size_t armedCount() const { return count; }
+    size_t capacity() const { return timers.size(); }
+    uint64_t now() const { return current; }
+
+    // Processes every tick up to and including `tick`, calling onExpire(id)
+    // for each timer that fires. The callback may schedule or cancel any
+    // timer, including the one that fired. Returns the number fired.
+    template <typename Handler>
+    size_t advance(uint64_t tick, Handler&& onExpire) {
+        size_t fired = 0;
+        while (current <= tick) {
+            if (count == 0) {
+                current = tick + 1;
+                break;
+            }
+            uint32_t slot = static_cast<uint32_t>(current & (Slots - 1));
+            if (slot == 0) {
+                for (unsigned level = 1; level < Levels; ++level) {
+                    uint32_t index = static_cast<uint32_t>((current >> (SlotBits * level)) & (Slots - 1));
+                    cascade(level, index);
+                    if (index != 0) {
+                        break;
+                    }
+                }
+            }
+            // Detach the due slot first, so timers re-armed for this tick
+            // from the callback wait for the next one
+            uint32_t id = heads[slot];
+            heads[slot] = None;
+            while (id != None) {
+                uint32_t next = timers[id].next;
+                link(id, Firing);
+                id = next;
+            }
+            ++current;
+            while (heads[Firing] != None) {
+                id = heads[Firing];
+                unlink(id);
+                --count;
+                ++fired;
+                onExpire(id);
+            }
+        }
+        return fired;
+    }
+};
+
+#endif // TIMER_WHEEL_H
@@ -0,0 +1,212 @@
+#ifndef TRANSPORT_PROFILE_H
+#define TRANSPORT_PROFILE_H
+
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+#include "msquic.h"
+
+// Named set of QUIC transport settings. The client, server and proxy build
+// their QUIC_SETTINGS from a profile instead of inline constants, so a
+// setting can be changed from a file and its cost measured (bench_profiles).
+// The defaults are what the binaries used before profiles existed.
+struct TransportProfile {
+    std::string name = "default";
+    QUIC_CONGESTION_CONTROL_ALGORITHM congestionControl = QUIC_CONGESTION_CONTROL_ALGORITHM_CUBIC;
+    bool pacing = true;
+    bool sendBuffering = true;
+    uint32_t initialRttMs = 333;          // RTT assumed until the first sample
+    uint32_t maxAckDelayMs = 25;          // how long the peer may hold back an ACK
+    uint32_t keepAliveIntervalMs = 1000;  // 0 sends no keep-alives
+    uint64_t idleTimeoutMs = 30000;       // closes a connection that has been silent this long
+    uint32_t disconnectTimeoutMs = 30000; // gives up on a peer that stops acknowledging
+
+    // Sets the profile's fields; any other settings are left alone
+    void apply(QUIC_SETTINGS& settings) const {
+        settings.IsSet.CongestionControlAlgorithm = 1;
+        settings.CongestionControlAlgorithm = static_cast<uint16_t>(congestionControl);
+        settings.IsSet.PacingEnabled = 1;
+        settings.PacingEnabled = pacing;
+        settings.IsSet.SendBufferingEnabled = 1;
+        settings.SendBufferingEnabled = sendBuffering;
+        settings.IsSet.InitialRttMs = 1;
+        settings.InitialRttMs = initialRttMs;
+        settings.IsSet.MaxAckDelayMs = 1;
+        settings.MaxAckDelayMs = maxAckDelayMs;
+        settings.IsSet.KeepAliveIntervalMs = 1;
+        settings.KeepAliveIntervalMs = keepAliveIntervalMs;
+        settings.IsSet.IdleTimeoutMs = 1;
+        settings.IdleTimeoutMs = idleTimeoutMs;
+        settings.IsSet.DisconnectTimeoutMs = 1;
+        settings.DisconnectTimeoutMs = disconnectTimeoutMs;
+    }
+};
+
+// The built-in profiles, which a profile file can override or extend. The
+// file is INI-style: a [name] line starts a profile, followed by key = value
+// lines; '#' starts a comment. A new profile starts from the defaults, and a
+// section for an existing profile changes only the keys it lists.
+//
+//   [lossy-wireless]
+//   congestion_control = bbr    # cubic or bbr
+//   pacing = on                 # on/off, true/false or 1/0
+//   initial_rtt_ms = 80
+//
+// Other keys: send_buffering, max_ack_delay_ms, keep_alive_ms,
+// idle_timeout_ms and disconnect_timeout_ms.
+class TransportProfiles {
+    std::map<std::string, TransportProfile> profiles;
+
+    static bool parseBool(const std::string& value, bool& out) {
+        if (value == "on" || value == "true" || value == "1") {
+            out = true;
+        } else if (value == "off" || value == "false" || value == "0") {
+            out = false;
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    template <typename T>
+    static bool parseNumber(const std::string& value, T& out) {
+        if (value.empty() || value.find_first_not_of("0123456789") != std::string::npos || value.size() > 10) {
+            return false;
+        }
+        uint64_t number = std::stoull(value);
+        if (number > static_cast<uint64_t>(static_cast<T>(-1))) {
+            return false;
+        }
+        out = static_cast<T>(number);
+        return true;
+    }
+
+    static bool setKey(TransportProfile& profile, const std::string& key, const std::string& value) {
+        if (key == "congestion_control") {
+            if (value == "cubic") {
+                profile.congestionControl = QUIC_CONGESTION_CONTROL_ALGORITHM_CUBIC;
+            } else if (value == "bbr") {
+                profile.congestionControl = QUIC_CONGESTION_CONTROL_ALGORITHM_BBR;
+            } else {
+                return false;
+            }
+            return true;
+        }
+        if (key == "pacing") return parseBool(value, profile.pacing);
+        if (key == "send_buffering") return parseBool(value, profile.sendBuffering);
+        if (key == "initial_rtt_ms") return parseNumber(value, profile.initialRttMs);
+        if (key == "max_ack_delay_ms") return parseNumber(value, profile.maxAckDelayMs);
+        if (key == "keep_alive_ms") return parseNumber(value, profile.keepAliveIntervalMs);
+        if (key == "idle_timeout_ms") return parseNumber(value, profile.idleTimeoutMs);
+        if (key == "disconnect_timeout_ms") return parseNumber(value, profile.disconnectTimeoutMs);
+        return false;
+    }
+
+    static std::string trim(const std::string& text) {
+        size_t begin = text.find_first_not_of(" \t\r");
+        if (begin == std::string::npos) {
+            return std::string();
+        }
+        return text.substr(begin, text.find_last_not_of(" \t\r") - begin + 1);
+    }
+
+public:
+    TransportProfiles() {
+        add(TransportProfile());
+
+        // Small, frequent setpoints: no pacing delay, quick ACKs, and a dead
+        // peer is noticed in about a second
+        TransportProfile control;
+        control.name = "low-latency-control";
+        control.pacing = false;
+        control.initialRttMs = 10;
+        control.maxAckDelayMs = 5;
+        control.keepAliveIntervalMs = 250;
+        control.idleTimeoutMs = 5000;
+        control.disconnectTimeoutMs = 1000;
+        add(control);
+
+        // Camera and sensor streams: BBR fills the pipe without building queues
+        TransportProfile bulk;
+        bulk.name = "bulk-telemetry";
+        bulk.congestionControl = QUIC_CONGESTION_CONTROL_ALGORITHM_BBR;
+        bulk.initialRttMs = 100;
+        add(bulk);
+
+        // Wi-Fi and cellular: BBR does not treat random loss as congestion,
+        // and frequent keep-alives hold NAT bindings open
+        TransportProfile wireless;
+        wireless.name = "lossy-wireless";
+        wireless.congestionControl = QUIC_CONGESTION_CONTROL_ALGORITHM_BBR;
+        wireless.initialRttMs = 100;
+        wireless.maxAckDelayMs = 10;
+        wireless.keepAliveIntervalMs = 500;
+        wireless.disconnectTimeoutMs = 10000;
+        add(wireless);
+    }
+
+    void add(const TransportProfile& profile) { profiles[profile.name] = profile; }
+
+    const TransportProfile* find(const std::string& name) const {
+        auto it = profiles.find(name);
+        return it == profiles.end() ? nullptr : &it->second;
+    }
+
+    std::vector<std::string> names() const {
+        std::vector<std::string> result;
+        for (const auto& entry : profiles) {
+            result.push_back(entry.first);
+        }
+        return result;
+    }
+
+    // Reads profiles in the format above. On error nothing is changed and
+    // `error` names the offending line.
+    bool load(std::istream& in, std::string& error) {
+        std::map<std::string, TransportProfile> updated = profiles;
+        TransportProfile* current = nullptr;
+        std::string line;
+        for (int number = 1; std::getline(in, line); ++number) {
+            line = trim(line.substr(0, line.find('#')));
+            if (line.empty()) {
+                continue;
+            }
+            if (line.front() == '[' && line.back() == ']') {
+                std::string name = trim(line.substr(1, line.size() - 2));
+                if (name.empty()) {
+                    error = "line " + std::to_string(number) + ": empty profile name";
+                    return false;
+                }
+                current = &updated[name];
+                current->name = name;
+                continue;
+            }
+            size_t equals = line.find('=');
+            std::string key = trim(line.substr(0, equals));
+            std::string value = equals == std::string::npos ? std::string() : trim(line.substr(equals + 1));
+            if (!current || equals == std::string::npos || !setKey(*current, key, value)) {
+                error = "line " + std::to_string(number) + ": invalid setting '" + line + "'";
+                return false;
+            }
+        }
+        profiles.swap(updated);
+        return true;
+    }
+
+    bool loadFile(const std::string& path, std::string& error) {
+        std::ifstream in(path);
+        if (!in) {
+            error = "cannot open " + path;
+            return false;
+        }
+        if (!load(in, error)) {
+            error = path + ": " + error;
+            return false;
+        }
+        return true;
+    }
+};
+
+#endif // TRANSPORT_PROFILE_H
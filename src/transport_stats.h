@@ -0,0 +1,153 @@
+#ifndef TRANSPORT_STATS_H
+#define TRANSPORT_STATS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "msquic.h"
+#include "metrics.h"
+
+// QUIC transport statistics of one connection at one point in time
+struct TransportSnapshot {
+    uint32_t rttUs{0};
+    uint32_t minRttUs{0};
+    uint32_t rttVarianceUs{0};
+    uint32_t congestionWindow{0};
+    uint64_t bytesInFlight{0};
+    uint64_t sentPackets{0};
+    uint64_t lostPackets{0};          // suspected lost, including spurious
+    uint64_t spuriousLostPackets{0};
+    uint64_t receivedPackets{0};
+    uint32_t congestionEvents{0};
+
+    void assign(const QUIC_STATISTICS_V2& stats) {
+        rttUs = stats.Rtt;
+        minRttUs = stats.MinRtt;
+        rttVarianceUs = stats.RttVariance;
+        congestionWindow = stats.SendCongestionWindow;
+        sentPackets = stats.SendTotalPackets;
+        lostPackets = stats.SendSuspectedLostPackets;
+        spuriousLostPackets = stats.SendSpuriousLostPackets;
+        receivedPackets = stats.RecvTotalPackets;
+        congestionEvents = stats.SendCongestionCount;
+    }
+};
+
+// Latest transport statistics of a connection. The connection's own msquic
+// worker samples QUIC_PARAM_CONN_STATISTICS_V2 into it, at most once per
+// interval, from an event it is handling anyway; on the worker the GetParam
+// call runs inline and never waits for another thread. The metrics thread
+// reads it. Fields are separate relaxed atomics, so a scrape may mix two
+// consecutive samples, which is fine for monitoring.
+class TransportStats {
+    std::atomic<uint64_t> nextSampleUs{0};
+    std::atomic<uint32_t> rttUs{0};
+    std::atomic<uint32_t> minRttUs{0};
+    std::atomic<uint32_t> rttVarianceUs{0};
+    std::atomic<uint32_t> congestionWindow{0};
+    std::atomic<uint64_t> bytesInFlight{0};
+    std::atomic<uint64_t> sentPackets{0};
+    std::atomic<uint64_t> lostPackets{0};
+    std::atomic<uint64_t> spuriousLostPackets{0};
+    std::atomic<uint64_t> receivedPackets{0};
+    std::atomic<uint32_t> congestionEvents{0};
+
+public:
+    static uint64_t clockUs() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // Samples the connection if the interval has passed since the last sample
+    void maybeSample(const QUIC_API_TABLE* msquic, HQUIC connection, uint64_t intervalUs) {
+        uint64_t now = clockUs();
+        if (now < nextSampleUs.load(std::memory_order_relaxed)) {
+            return;
+        }
+        nextSampleUs.store(now + intervalUs, std::memory_order_relaxed);
+        QUIC_STATISTICS_V2 stats = {};
+        uint32_t size = sizeof(stats);
+        if (QUIC_SUCCEEDED(msquic->GetParam(connection, QUIC_PARAM_CONN_STATISTICS_V2, &size, &stats))) {
+            TransportSnapshot snapshot;
+            snapshot.assign(stats);
+            store(snapshot);
+        }
+    }
+
+    // From QUIC_CONNECTION_EVENT_NETWORK_STATISTICS, which reports it on every change
+    void setBytesInFlight(uint64_t bytes) { bytesInFlight.store(bytes, std::memory_order_relaxed); }
+
+    void store(const TransportSnapshot& s) {
+        rttUs.store(s.rttUs, std::memory_order_relaxed);
+        minRttUs.store(s.minRttUs, std::memory_order_relaxed);
+        rttVarianceUs.store(s.rttVarianceUs, std::memory_order_relaxed);
+        congestionWindow.store(s.congestionWindow, std::memory_order_relaxed);
+        sentPackets.store(s.sentPackets, std::memory_order_relaxed);
+        lostPackets.store(s.lostPackets, std::memory_order_relaxed);
+        spuriousLostPackets.store(s.spuriousLostPackets, std::memory_order_relaxed);
+        receivedPackets.store(s.receivedPackets, std::memory_order_relaxed);
+        congestionEvents.store(s.congestionEvents, std::memory_order_relaxed);
+    }
+
+    TransportSnapshot load() const {
+        TransportSnapshot s;
+        s.rttUs = rttUs.load(std::memory_order_relaxed);
+        s.minRttUs = minRttUs.load(std::memory_order_relaxed);
+        s.rttVarianceUs = rttVarianceUs.load(std::memory_order_relaxed);
+        s.congestionWindow = congestionWindow.load(std::memory_order_relaxed);
+        s.bytesInFlight = bytesInFlight.load(std::memory_order_relaxed);
+        s.sentPackets = sentPackets.load(std::memory_order_relaxed);
+        s.lostPackets = lostPackets.load(std::memory_order_relaxed);
+        s.spuriousLostPackets = spuriousLostPackets.load(std::memory_order_relaxed);
+        s.receivedPackets = receivedPackets.load(std::memory_order_relaxed);
+        s.congestionEvents = congestionEvents.load(std::memory_order_relaxed);
+        return s;
+    }
+};
+
+// Writes the transport metrics of a set of connections, one family at a
+// time; labels[i] identifies snapshots[i], e.g. connection="3"
+inline void WriteTransportMetrics(MetricsWriter& writer, const std::vector<std::string>& labels,
+                                  const std::vector<TransportSnapshot>& snapshots) {
+    struct Family {
+        const char* name;
+        const char* type;
+        const char* help;
+        double (*value)(const TransportSnapshot&);
+    };
+    static const Family families[] = {
+        {"teleop_quic_rtt_seconds", "gauge", "Smoothed round-trip time",
+         [](const TransportSnapshot& s) { return s.rttUs / 1e6; }},
+        {"teleop_quic_min_rtt_seconds", "gauge", "Minimum round-trip time",
+         [](const TransportSnapshot& s) { return s.minRttUs / 1e6; }},
+        {"teleop_quic_rtt_variance_seconds", "gauge", "Round-trip time variance",
+         [](const TransportSnapshot& s) { return s.rttVarianceUs / 1e6; }},
+        {"teleop_quic_congestion_window_bytes", "gauge", "Congestion window",
+         [](const TransportSnapshot& s) { return static_cast<double>(s.congestionWindow); }},
+        {"teleop_quic_bytes_in_flight", "gauge", "Bytes sent and not yet acknowledged",
+         [](const TransportSnapshot& s) { return static_cast<double>(s.bytesInFlight); }},
+        {"teleop_quic_sent_packets_total", "counter", "Packets sent",
+         [](const TransportSnapshot& s) { return static_cast<double>(s.sentPackets); }},
+        {"teleop_quic_lost_packets_total", "counter", "Packets suspected lost",
+         [](const TransportSnapshot& s) { return static_cast<double>(s.lostPackets); }},
+        {"teleop_quic_spurious_lost_packets_total", "counter", "Packets suspected lost that were later acknowledged",
+         [](const TransportSnapshot& s) { return static_cast<double>(s.spuriousLostPackets); }},
+        {"teleop_quic_received_packets_total", "counter", "Packets received",
+         [](const TransportSnapshot& s) { return static_cast<double>(s.receivedPackets); }},
+        {"teleop_quic_congestion_events_total", "counter", "Congestion events",
+         [](const TransportSnapshot& s) { return static_cast<double>(s.congestionEvents); }},
+    };
+    if (snapshots.empty()) {
+        return;
+    }
+    for (const Family& family : families) {
+        writer.family(family.name, family.type, family.help);
+        for (size_t i = 0; i < snapshots.size(); ++i) {
+            writer.sample(family.name, family.value(snapshots[i]), labels[i]);
+        }
+    }
+}
+
+#endif // TRANSPORT_STATS_H